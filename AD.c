@@ -24,7 +24,6 @@
 
 
 #define NUM_AD_PINS 14
-#define NUM_AD_PINS_UNO 16
 
 #ifdef IM_A_ROACH
 #define BAT_VOLTAGE_MONITOR AD_PORTV3
@@ -33,9 +32,6 @@
 #define BAT_VOLTAGE_MONITOR BAT_VOLTAGE
 #endif
 
-#define BAT_VOLTAGE_LOCKOUT 263
-#define BAT_VOLTAGE_NO_BAT 169
-
 //#define AD_DEBUG_VERBOSE
 #ifdef AD_DEBUG_VERBOSE
 #include "serial.h"
@@ -44,19 +40,21 @@
 #define dbprintf(...)
 #endif
 
-
-//battery filter definitions
-#define FILTER_POWER (11)
-#define KEEP_PERCENTAGE ((float).9)
-#define ADD_PERCENTAGE (1-KEEP_PERCENTAGE)
-
-#define KEEP_FILT ((int)((2<<(FILTER_POWER-1))*KEEP_PERCENTAGE))
-#define ADD_FILT ((int)((2<<(FILTER_POWER-1))*ADD_PERCENTAGE))
-#define SHIFT_FILT (FILTER_POWER)
 #define ALLADPINS (AD_PORTV3|AD_PORTV4|AD_PORTV5|AD_PORTV6|AD_PORTV7|AD_PORTV8|AD_PORTW3|AD_PORTW4|AD_PORTW5|AD_PORTW6|AD_PORTW7|AD_PORTW8|BAT_VOLTAGE|ROACH_LIGHT_SENSOR)
-#define BATFILT_HISTORY_LENGTH 2
-#define POINTS_PER_SECOND_PER_PIN 9345
-#define FREQUENCY_TO_SAMPLE 1
+
+//conversion timing, TAD = 2 * (ADCS + 1) peripheral clocks
+#define LEGACY_SAMC 29                  //timing used when no sample rate has been set
+#define LEGACY_ADCS 0x32
+#define CONVERSION_TADS 13              //12 TAD conversion and the sample to hold step,
+                                        //matches the 9345 points/s measured with the legacy timing
+#define MAX_SAMC 31
+#define MIN_ADCS 1                      //keeps TAD at or above the 83 ns minimum at 40 MHz
+#define MAX_ADCS 255
+#define MIN_SAMPLE_NS 2000              //the IR detectors and tape sensors are high impedance
+#define RATE_WINDOW_TICKS (CORE_TICKS_PER_MS * 250)
+#define HALF_BUFFER_WORDS 8             //each half of the A/D buffer when BUFM alternates
+#define BUFFER_STRIDE 4                 //ADC1BUFx are 16 bytes apart
+#define MAX_SCAN_HOOKS 4
 
 
 
@@ -76,35 +74,59 @@ static unsigned int AD1CSSL_MASKS[NUM_AD_PINS] = {(1 << _AD1CSSL_CSSL2_POSITION)
     (1 << _AD1CSSL_CSSL11_POSITION), (1 << _AD1CSSL_CSSL10_POSITION), (1 << _AD1CSSL_CSSL13_POSITION), (1 << _AD1CSSL_CSSL12_POSITION),
     (1 << _AD1CSSL_CSSL15_POSITION), (1 << _AD1CSSL_CSSL14_POSITION), (1 << _AD1CSSL_CSSL1_POSITION), (1 << _AD1CSSL_CSSL0_POSITION)};
 
-static unsigned int AD1PCFG_POS[NUM_AD_PINS] = {_AD1PCFG_PCFG2_POSITION, _AD1PCFG_PCFG3_POSITION,
-    _AD1PCFG_PCFG4_POSITION, _AD1PCFG_PCFG5_POSITION, _AD1PCFG_PCFG8_POSITION, _AD1PCFG_PCFG9_POSITION,
-    _AD1PCFG_PCFG11_POSITION, _AD1PCFG_PCFG10_POSITION, _AD1PCFG_PCFG13_POSITION, _AD1PCFG_PCFG12_POSITION,
-    _AD1PCFG_PCFG15_POSITION, _AD1PCFG_PCFG14_POSITION, _AD1PCFG_PCFG1_POSITION, _AD1PCFG_PCFG0_POSITION};
+//pins in the order the scan converts them, which is by AN number: AN0, AN1, AN2 ...
+static const unsigned char SCAN_ORDER[NUM_AD_PINS] = {13, 12, 0, 1, 2, 3, 4, 5, 7, 6, 9, 8, 11, 10};
 
-
-static unsigned int ActivePins;
-static unsigned int PinsToAdd;
-static unsigned int PinsToRemove;
-static unsigned int PinCount;
+/*
+ * Everything AD_ApplyConfig writes to the A/D, worked out ahead of time outside the
+ * interrupt. Two are kept so the next one can be built while the interrupt still reads
+ * the current one.
+ */
+typedef struct {
+    unsigned int Active;            //AD_PORTxxx pins
+    unsigned int Count;
+    unsigned int Cssl;
+    unsigned int Pcfg;              //pins to make analog
+    unsigned int RemPcfg;           //pins to give back to digital I/O
+    unsigned int Samc;
+    unsigned int Adcs;
+    unsigned int ScanRate;          //what Samc and Adcs give
+    unsigned int Scans;             //scans per interrupt
+    unsigned char Alternate;        //BUFM, the A/D fills one half while we read the other
+    signed char Slot[NUM_AD_PINS];  //buffer index of each pin, -1 when not scanned
+} ADConfig_t;
+
+static ADConfig_t Configs[2];
+static ADConfig_t * volatile Current = &Configs[0];
+static ADConfig_t * volatile Pending = NULL;
 static unsigned int ADValues[NUM_AD_PINS];
-static int PortMapping[NUM_AD_PINS];
+static uint32_t ADSums[NUM_AD_PINS];        //every sample since the last AD_ReadADSum
+static unsigned int SumScans[NUM_AD_PINS];
+static volatile uint32_t ApplyTicks = 0;   //worst reconfiguration seen in the interrupt
+static unsigned char Batching = FALSE;
 
 static char ADActive;
 static char ADNewData = FALSE;
 
 
-static int Filt_BatVoltage = 1023;
-static int CurFilt_BatVoltage = 0;
-static int PrevFilt_BatVoltage = 0;
-//static uint16_t BatFiltHistory[BATFILT_HISTORY_LENGTH] = {0};
-//static uint8_t BatFiltHistoryCurPoint = -1;
-static uint32_t PointsPerBatSamples = 0;
-static uint32_t SampleCount = 0;
+static unsigned int TargetRate = 0;         //samples per second per pin, 0 for the legacy timing
+static volatile unsigned int MeasuredRate = 0;
+static volatile unsigned int InterruptRate = 0;
+static volatile unsigned int ISRLoad = 0;  //per mille of the CPU
+static unsigned int WindowScans = 0;
+static unsigned int WindowInterrupts = 0;
+static uint32_t WindowBusy = 0;
+static uint32_t WindowStart;
+
+static AD_ScanHook_t ScanHooks[MAX_SCAN_HOOKS];
+static unsigned char NumScanHooks = 0;
 
 /*******************************************************************************
  * PRIVATE FUNCTION PROTOTYPES                                                            *
  ******************************************************************************/
-char AD_SetPins(void);
+static void AD_BuildConfig(unsigned int AddPins, unsigned int RemovePins);
+static void AD_SetTiming(ADConfig_t *Config);
+static void AD_ApplyConfig(void);
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -123,30 +145,38 @@ char AD_Init(void)
         return ERROR;
     }
     int pin = 0;
-    //ensure that the battery monitor is active
-    ActivePins = BAT_VOLTAGE_MONITOR;
     ADActive = TRUE;
-    AD_SetPins();
     for (pin = 0; pin < NUM_AD_PINS; pin++) {
         ADValues[pin] = -1;
     }
+    AD1CON1bits.FORM = 0; // output is unsigned integer
+    AD1CON1bits.SSRC = 0b111; // internal counter handles timing of sampling an conversion
+    AD1CON1bits.ASAM = 1; // start sampling again after conversion is complete
+
+    AD1CON2bits.VCFG = 0; // use AVdd and AVss for + and -
+    AD1CON2bits.CSCNA = 1; // mux inputs together
+    AD1CON2bits.BUFM = 0; // configure bugger as one large buffer
+
+    AD1CON3bits.ADRC = 0; // use Peripheral clock for timing
+
+    //ensure that the battery monitor is active
     IEC1bits.AD1IE = 0;
+    Current->Active = 0;
+    Current->Pcfg = 0;
+    AD_BuildConfig(BAT_VOLTAGE_MONITOR, 0);
+    AD_ApplyConfig();
     IFS1bits.AD1IF = 0;
     IPC6bits.AD1IP = 1;
     IPC6bits.AD1IS = 3;
     IEC1bits.AD1IE = 1;
     AD1CON1bits.ON = 1;
     ADNewData = FALSE;
-    //wait for first reading to ensure  battery monitor starts in the right spot
+    //wait for first reading so the battery service starts from a real value
     while (!AD_IsNewDataReady()) {
 #ifdef AD_DEBUG_VERBOSE
         PutChar('.');
 #endif
     }
-    //set the first values for the battery monitor filter
-    Filt_BatVoltage = AD_ReadADPin(BAT_VOLTAGE_MONITOR);
-    CurFilt_BatVoltage = Filt_BatVoltage;
-    PrevFilt_BatVoltage = Filt_BatVoltage;
 
     return SUCCESS;
 }
@@ -167,12 +197,12 @@ char AD_AddPins(unsigned int AddPins)
         dbprintf("%s returning ERROR with pins outside range: %X\r\n", __FUNCTION__, AddPins);
         return ERROR;
     }
-    if (ActivePins & AddPins) {
+    if (Current->Active & AddPins) {
         dbprintf("%s Returning ERROR for pins already in state: %X \r\n", __FUNCTION__, AddPins);
         return ERROR;
     }
     //setting the pins to be added during the next interrupt cycle
-    PinsToAdd |= AddPins;
+    AD_BuildConfig(AddPins, 0);
     return SUCCESS;
 }
 
@@ -192,7 +222,7 @@ char AD_RemovePins(unsigned int RemovePins)
         dbprintf("%s returning ERROR with pins outside range: %X\r\n", __FUNCTION__, RemovePins);
         return ERROR;
     }
-    if (!(ActivePins & RemovePins)) {
+    if (!(Current->Active & RemovePins)) {
         dbprintf("%s Returning ERROR for pins already in state: %X \r\n", __FUNCTION__, RemovePins);
         return ERROR;
     }
@@ -201,8 +231,8 @@ char AD_RemovePins(unsigned int RemovePins)
         return ERROR;
     }
 
-    //setting the pins to be added during the next interrupt cycle
-    PinsToRemove |= RemovePins;
+    //setting the pins to be removed during the next interrupt cycle
+    AD_BuildConfig(0, RemovePins);
     return SUCCESS;
 }
 
@@ -217,7 +247,7 @@ char AD_RemovePins(unsigned int RemovePins)
  * @author Max Dunne, 2013.08.15 */
 unsigned int AD_ActivePins(void)
 {
-    return ActivePins;
+    return Current->Active;
 }
 
 /**
@@ -248,17 +278,12 @@ unsigned int AD_ReadADPin(unsigned int Pin)
         dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
         return ERROR;
     }
-    if (!(ActivePins & Pin)) {
+    if (!(Current->Active & Pin)) {
         dbprintf("%s returning error with unactivated pin: %X %X\r\n", __FUNCTION__, Pin);
         return ERROR;
     }
-    unsigned char TranslatedPin = 0;
-    while (Pin > 1) {
-
-        Pin >>= 1;
-        TranslatedPin++;
-    }
-    return ADValues[PortMapping[TranslatedPin]];
+    //the pin number is the position of the top bit, CLZ is one instruction on the M4K
+    return ADValues[Current->Slot[31 - __builtin_clz(Pin)]];
 }
 
 /**
@@ -275,98 +300,318 @@ void AD_End(void)
     }
     IEC1bits.AD1IE = 0;
     AD1CON1CLR = _AD1CON1_ON_MASK;
-    PinsToRemove = ALLADPINS;
-    AD_SetPins();
+    AD_BuildConfig(0, ALLADPINS);
+    AD_ApplyConfig();
+    AD1CON1CLR = _AD1CON1_ON_MASK;
     for (pin = 0; pin < NUM_AD_PINS; pin++) {
         ADValues[pin] = -1;
     }
-    ActivePins = 0;
-    PinCount = 0;
     //CloseADC10();    
     AD1PCFG = 0xFF;
 }
 
-/*******************************************************************************
- * PRIVATE FUNCTIONS                                                       *
- ******************************************************************************/
+/**
+ * @function AD_AddScanHook(AD_ScanHook_t Hook)
+ * @param Hook - function to be called from the A/D interrupt after every scan
+ * @return SUCCESS or ERROR
+ * @brief Registers a function that runs inside the A/D interrupt once the buffer of the
+ *        latest scan has been copied, so AD_ReadADPin returns the new values. Used by
+ *        drivers that need every sample of a channel rather than the latest one.
+ * @note Hooks run at interrupt priority, keep them short and do not print from them. */
+char AD_AddScanHook(AD_ScanHook_t Hook)
+{
+    unsigned char CurHook;
+    if (Hook == NULL) {
+        return ERROR;
+    }
+    for (CurHook = 0; CurHook < NumScanHooks; CurHook++) {
+        if (ScanHooks[CurHook] == Hook) {
+            return SUCCESS;
+        }
+    }
+    if (NumScanHooks >= MAX_SCAN_HOOKS) {
+        dbprintf("%s returning ERROR, no free scan hooks\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    ScanHooks[NumScanHooks] = Hook;
+    NumScanHooks++;
+    return SUCCESS;
+}
 
 /**
- * @function AD_SetPins(void)
+ * @function AD_GetScanRate(void)
  * @param None
- * @return SUCCESS OR ERROR
- * @brief Connects pins in PinstoAdd to the A/D system and removes the pins in PinsToRemove
- * @note Private Function. DO NOT USE.
- * @author Max Dunne, 2013.08.15 */
-char AD_SetPins(void)
+ * @return number of complete scans (samples per pin) each second
+ * @brief Every active pin is sampled once per scan, so this is also the sample rate seen
+ *        by a scan hook. It is worked out from the conversion timing and changes whenever
+ *        pins are added or removed or the sample rate is set. */
+unsigned int AD_GetScanRate(void)
+{
+    return Current->ScanRate;
+}
+
+/**
+ * @function AD_SetSampleRate(unsigned int SamplesPerSecond)
+ * @param SamplesPerSecond - wanted samples per second on each active pin, 0 to go back
+ *        to the original fixed timing
+ * @return SUCCESS or ERROR
+ * @brief The sample and conversion times are chosen for this rate and the number of
+ *        active pins, and picked again whenever pins are added or removed. Takes effect
+ *        at the next scan. The rate is clamped to what the A/D can do, check
+ *        AD_GetScanRate for the rate actually set up. */
+char AD_SetSampleRate(unsigned int SamplesPerSecond)
 {
     if (!ADActive) {
+        dbprintf("%s called before enable\r\n", __FUNCTION__);
         return ERROR;
     }
-    unsigned int cssl = 0;
-    unsigned int pcfg = 0;
-    unsigned int rempcfg = 0;
-    unsigned char CurPin = 0;
-    unsigned int CurPinOrder = 0x00;
-    int ADMapping[NUM_AD_PINS_UNO];
-    AD1CON1CLR = _AD1CON1_ON_MASK; //disable A/D system and interrupt
-    IEC1bits.AD1IE = 0;
-    PinCount = 0;
+    TargetRate = SamplesPerSecond;
+    AD_BuildConfig(0, 0);
+    return SUCCESS;
+}
+
+/**
+ * @function AD_GetMeasuredScanRate(void)
+ * @param None
+ * @return scans per second counted by the interrupt over the last quarter second, 0
+ *         until the first window after a change has finished */
+unsigned int AD_GetMeasuredScanRate(void)
+{
+    return MeasuredRate;
+}
+
+/**
+ * @function AD_GetReconfigureTicks(void)
+ * @param None
+ * @return the longest time, in core timer ticks, the A/D interrupt has spent applying a
+ *         pin or rate change */
+unsigned int AD_GetReconfigureTicks(void)
+{
+    return ApplyTicks;
+}
+
+/**
+ * @function AD_SetBatching(unsigned char Enable)
+ * @param Enable - TRUE to read several scans per interrupt
+ * @return SUCCESS or ERROR
+ * @brief With batching the A/D buffer is split in two halves (BUFM) and the interrupt
+ *        only fires once a half is full, so with N pins it comes every 8 / N scans.
+ *        Scan hooks are still called once for each scan. With more than 4 pins only one
+ *        scan fits in a half, which still gives the interrupt a whole scan of slack
+ *        before the buffer is overwritten. Takes effect at the next scan. */
+char AD_SetBatching(unsigned char Enable)
+{
+    if (!ADActive) {
+        dbprintf("%s called before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    Batching = Enable ? TRUE : FALSE;
+    AD_BuildConfig(0, 0);
+    return SUCCESS;
+}
+
+/**
+ * @function AD_ReadADSum(unsigned int Pin, unsigned int *Samples)
+ * @param Pin - Used #defined AD_PORTxxx to select pin
+ * @param Samples - set to the number of samples in the sum
+ * @return sum of every sample of the pin since the last call, 0 for an inactive pin
+ * @brief Lets a slow reader average all of the samples it missed rather than take the
+ *        latest one. The sum restarts when pins or the rate change. */
+unsigned int AD_ReadADSum(unsigned int Pin, unsigned int *Samples)
+{
+    unsigned int Enabled = IEC1bits.AD1IE;
+    signed char Slot;
+    uint32_t Sum;
+
+    *Samples = 0;
+    if (!ADActive || !(Current->Active & Pin)) {
+        return 0;
+    }
+    IEC1CLR = _IEC1_AD1IE_MASK;
+    Slot = Current->Slot[31 - __builtin_clz(Pin)];
+    Sum = ADSums[Slot];
+    *Samples = SumScans[Slot];
+    ADSums[Slot] = 0;
+    SumScans[Slot] = 0;
+    if (Enabled) {
+        IEC1SET = _IEC1_AD1IE_MASK;
+    }
+    return Sum;
+}
+
+/**
+ * @function AD_GetISRLoad(void)
+ * @param None
+ * @return share of the CPU spent in the A/D interrupt over the last quarter second, in
+ *         tenths of a percent. Counts from the first line of the handler to the last, the
+ *         context save and restore around it are not included. */
+unsigned int AD_GetISRLoad(void)
+{
+    return ISRLoad;
+}
+
+/**
+ * @function AD_PrintDiagnostics(void)
+ * @param None
+ * @return None
+ * @brief Prints the scan setup and the interrupt measurements, for the "a" command. */
+void AD_PrintDiagnostics(void)
+{
+    ADConfig_t *Config = Current;
+
+    printf("A/D %u pins, %s, %u scan%s per interrupt\r\n", Config->Count,
+            Config->Alternate ? "batched" : "single", Config->Scans, (Config->Scans == 1) ? "" : "s");
+    while (!IsTransmitEmpty());
+    printf("rate %u/s set, %u/s measured, %u interrupts/s\r\n", Config->ScanRate, MeasuredRate, InterruptRate);
+    while (!IsTransmitEmpty());
+    printf("interrupt load %u.%u%%, worst reconfigure %u ticks\r\n", ISRLoad / 10, ISRLoad % 10, ApplyTicks);
+    while (!IsTransmitEmpty());
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                       *
+ ******************************************************************************/
 
-    //determine the new set of active pins
-    ActivePins |= PinsToAdd;
-    ActivePins &= ~PinsToRemove;
-    //initialize the mapping array to -1
-    for (CurPin = 0; CurPin < NUM_AD_PINS_UNO; CurPin++) {
-        ADMapping[CurPin] = -1;
+/**
+ * @function AD_BuildConfig(unsigned int AddPins, unsigned int RemovePins)
+ * @param AddPins - AD_PORTxxx pins to scan on top of the latest set
+ * @param RemovePins - AD_PORTxxx pins to stop scanning
+ * @return None
+ * @brief Works out the registers and the pin to buffer table for the latest pin set,
+ *        queued or current, with the changes made, and queues them for the interrupt
+ *        to apply at the end of the next scan. The A/D interrupt is held off from
+ *        choosing the latest set until the queued config is rewritten, as applying
+ *        clears Pending.
+ * @note Private Function. */
+static void AD_BuildConfig(unsigned int AddPins, unsigned int RemovePins)
+{
+    ADConfig_t *Next;
+    unsigned int Active;
+    unsigned char Order;
+    unsigned char CurPin;
+    unsigned int Enabled = IEC1bits.AD1IE;
+
+    IEC1CLR = _IEC1_AD1IE_MASK;
+    Active = ((Pending != NULL) ? Pending->Active : Current->Active);
+    Active = (Active | AddPins) & ~RemovePins;
+    Next = (Current == &Configs[0]) ? &Configs[1] : &Configs[0];
+    Next->Active = Active;
+    Next->Count = 0;
+    Next->Cssl = 0;
+    Next->Pcfg = 0;
+    //walk the pins in scan order, so each one's buffer slot is just the count so far
+    for (Order = 0; Order < NUM_AD_PINS; Order++) {
+        CurPin = SCAN_ORDER[Order];
+        Next->Slot[CurPin] = -1;
+        if (Active & (1 << CurPin)) {
+            Next->Cssl |= AD1CSSL_MASKS[CurPin];
+            Next->Pcfg |= AD1PCFG_MASKS[CurPin];
+            Next->Slot[CurPin] = Next->Count;
+            Next->Count++;
+        }
     }
-    // memset(ADMapping,-1,NUM_AD_PINS_UNO);
-    for (CurPin = 0; CurPin < NUM_AD_PINS; CurPin++) {
-        PortMapping[CurPin] = -1; //reset all ports to unmapped
-        if ((ActivePins & (1 << CurPin)) != 0) { //if one of the pins is active
-            //build masks and remap pins
-            cssl |= AD1CSSL_MASKS[CurPin];
-            pcfg |= AD1PCFG_MASKS[CurPin];
-            ADMapping[AD1PCFG_POS[CurPin]] = CurPin;
-            PinCount++;
+    Next->RemPcfg = Current->Pcfg & ~Next->Pcfg;
+    Next->Scans = 1;
+    Next->Alternate = FALSE;
+    if (Batching && (Next->Count != 0) && (Next->Count <= HALF_BUFFER_WORDS)) {
+        Next->Scans = HALF_BUFFER_WORDS / Next->Count;
+        Next->Alternate = TRUE;
+    }
+    AD_SetTiming(Next);
+    Pending = Next;
+    if (Enabled) {
+        IEC1SET = _IEC1_AD1IE_MASK;
+    }
+}
+
+/**
+ * @function AD_SetTiming(ADConfig_t *Config)
+ * @param Config - config to fill in, Count must already be set
+ * @return None
+ * @brief Picks SAMC and ADCS for TargetRate with the pins in the config. The smallest TAD
+ *        that lets SAMC reach the conversion period is used, which leaves the longest
+ *        sample time. Sets ScanRate to the rate that timing really gives.
+ * @note Private Function. */
+static void AD_SetTiming(ADConfig_t *Config)
+{
+    unsigned int PBClock = BOARD_GetPBClock();
+    unsigned int Samc = LEGACY_SAMC;
+    unsigned int Adcs = LEGACY_ADCS;
+    unsigned int Conversion;
+    unsigned int Tad;
+    unsigned int MinSample;
+
+    if ((TargetRate != 0) && (Config->Count != 0)) {
+        //peripheral clocks for each conversion at the requested rate
+        Conversion = PBClock / (TargetRate * Config->Count);
+        MinSample = (PBClock / 1000000) * MIN_SAMPLE_NS / 1000;
+        for (Adcs = MIN_ADCS; Adcs <= MAX_ADCS; Adcs++) {
+            Tad = 2 * (Adcs + 1);
+            if ((Conversion / Tad) <= (MAX_SAMC + CONVERSION_TADS)) {
+                break;
+            }
         }
-        if ((PinsToRemove & (1 << CurPin)) != 0) {//generate removal masks
-            rempcfg |= AD1PCFG_MASKS[CurPin];
+        if (Adcs > MAX_ADCS) {
+            //slower than the A/D can go
+            Adcs = MAX_ADCS;
+            Samc = MAX_SAMC;
+        } else {
+            Tad = 2 * (Adcs + 1);
+            Samc = (Conversion / Tad > CONVERSION_TADS) ? (Conversion / Tad - CONVERSION_TADS) : 0;
+            //faster than the sensors can be sampled, settle for a lower rate
+            if ((Samc * Tad) < MinSample) {
+                Samc = (MinSample + Tad - 1) / Tad;
+            }
         }
     }
-    for (CurPin = 0; CurPin < NUM_AD_PINS_UNO; CurPin++) {//translate AD Mapping to Port Mapping
-        if (ADMapping[CurPin] != -1) {
-            PortMapping[ADMapping[CurPin]] = CurPinOrder;
-            CurPinOrder++;
-        }
+    Config->Samc = Samc;
+    Config->Adcs = Adcs;
+    if (Config->Count != 0) {
+        Config->ScanRate = PBClock / (2 * (Adcs + 1) * (Samc + CONVERSION_TADS) * Config->Count);
+    } else {
+        Config->ScanRate = 0;
     }
+}
 
-    AD1CON1bits.FORM = 0; // output is unsigned integer
-    AD1CON1bits.SSRC = 0b111; // internal counter handles timing of sampling an conversion
-    AD1CON1bits.ASAM = 1; // start sampling again after conversion is complete
-
-    AD1CON2bits.VCFG = 0; // use AVdd and AVss for + and -
-    AD1CON2bits.CSCNA = 1; // mux inputs together
-    AD1CON2bits.SMPI = PinCount - 1; // set the number to scan for 1 less than wanted as zero is 1 to scan
-    AD1CON2bits.BUFM = 0; // configure bugger as one large buffer
+/**
+ * @function AD_ApplyConfig(void)
+ * @param None
+ * @return None
+ * @brief Writes the pending config to the A/D and makes it current. Only register
+ *        writes, so the time it takes does not depend on the pins. Called from the
+ *        interrupt at the end of a scan, or with the interrupt off.
+ * @note Private Function. */
+static void AD_ApplyConfig(void)
+{
+    ADConfig_t *Next = Pending;
+    uint32_t Start = _CP0_GET_COUNT();
+    unsigned char CurPin;
 
-    AD1CON3bits.ADRC = 0; // use Peripheral clock for timing
-    AD1CON3bits.SAMC = 29; // set the sample time, completely arbitrary, nearly the slowest possible
-    AD1CON3bits.ADCS = 0x32; // set the conversion time, again arbitrary 
-
-    AD1PCFGCLR = pcfg;
-    TRISBSET = pcfg;
-    AD1CSSL = cssl;
-    //    OpenADC10(ADC_MODULE_ON | ADC_FORMAT_INTG | ADC_CLK_AUTO | ADC_AUTO_SAMPLING_ON,
-    //            ADC_VREF_AVDD_AVSS | ADC_SCAN_ON | ((PinCount - 1) << _AD1CON2_SMPI_POSITION) | ADC_BUF_16,
-    //            ADC_SAMPLE_TIME_29 | ADC_CONV_CLK_51Tcy2 | ADC_CONV_CLK_PB, pcfg, cssl);
-    AD1PCFGSET = rempcfg;
+    AD1CON1CLR = _AD1CON1_ON_MASK;
+    AD1CON2bits.SMPI = (Next->Count * Next->Scans) - 1; // set the number to scan for 1 less than wanted as zero is 1 to scan
+    AD1CON2bits.BUFM = Next->Alternate;
+    AD1CON3bits.SAMC = Next->Samc;
+    AD1CON3bits.ADCS = Next->Adcs;
+    AD1PCFGCLR = Next->Pcfg;
+    TRISBSET = Next->Pcfg;
+    AD1CSSL = Next->Cssl;
+    AD1PCFGSET = Next->RemPcfg;
     AD1CON1SET = _AD1CON1_ON_MASK;
-    //recalculate interval between battery samples
-    PointsPerBatSamples = (POINTS_PER_SECOND_PER_PIN / PinCount) / (float) FREQUENCY_TO_SAMPLE;
-    PinsToAdd = 0;
-    PinsToRemove = 0;
-    IEC1bits.AD1IE = 1;
-    return SUCCESS;
+    Current = Next;
+    Pending = NULL;
+    for (CurPin = 0; CurPin < NUM_AD_PINS; CurPin++) {
+        ADSums[CurPin] = 0;
+        SumScans[CurPin] = 0;
+    }
+    //start a new measurement window at the new rate
+    MeasuredRate = 0;
+    WindowScans = 0;
+    WindowInterrupts = 0;
+    WindowBusy = 0;
+    WindowStart = _CP0_GET_COUNT();
+    if ((WindowStart - Start) > ApplyTicks) {
+        ApplyTicks = WindowStart - Start;
+    }
 }
 
 /**
@@ -378,31 +623,48 @@ char AD_SetPins(void)
  * @author Max Dunne, 2013.08.25 */
 void __ISR(_ADC_VECTOR) ADCIntHandler(void)
 {
+    uint32_t Entry = _CP0_GET_COUNT();
+    uint32_t Now;
+    ADConfig_t *Config = Current;
+    const volatile unsigned int *Buffer = &ADC1BUF0;
+    unsigned int Word = 0;
+    unsigned char Scan;
     unsigned char CurPin = 0;
+    unsigned char CurHook;
     IFS1bits.AD1IF = 0;
-    for (CurPin = 0; CurPin <= PinCount; CurPin++) {
-        ADValues[CurPin] = (*(&ADC1BUF0+((CurPin) * 4))); //read in new set of values, pointer math from microchip
-    }
-    //calculate new filtered battery voltage
-    Filt_BatVoltage = (Filt_BatVoltage * KEEP_FILT + AD_ReadADPin(BAT_VOLTAGE_MONITOR) * ADD_FILT) >> SHIFT_FILT;
-
-    SampleCount++;
-    if (SampleCount > PointsPerBatSamples) {//if sample time has passed
-        PrevFilt_BatVoltage = CurFilt_BatVoltage;
-        CurFilt_BatVoltage = Filt_BatVoltage;
-        SampleCount = 0;
-        //check for battery undervoltage check
-        if ((CurFilt_BatVoltage <= BAT_VOLTAGE_LOCKOUT) && (PrevFilt_BatVoltage <= BAT_VOLTAGE_LOCKOUT) && (AD_ReadADPin(BAT_VOLTAGE_MONITOR) > BAT_VOLTAGE_NO_BAT)) {
-            BOARD_End();
-            while (1) {
-                printf("Battery is undervoltage with reading %d, Going to sleep\r\n", AD_ReadADPin(BAT_VOLTAGE_MONITOR));
-                while (!IsTransmitEmpty());
-            }
+    //BUFS set means the A/D is filling the top half, so the bottom half is ours
+    if (Config->Alternate && !AD1CON2bits.BUFS) {
+        Buffer += HALF_BUFFER_WORDS * BUFFER_STRIDE;
+    }
+    for (Scan = 0; Scan < Config->Scans; Scan++) {
+        for (CurPin = 0; CurPin < Config->Count; CurPin++) {
+            ADValues[CurPin] = Buffer[Word * BUFFER_STRIDE]; //read in new set of values, pointer math from microchip
+            ADSums[CurPin] += ADValues[CurPin];
+            SumScans[CurPin]++;
+            Word++;
+        }
+        //hand the fresh scan to any drivers that process every sample
+        for (CurHook = 0; CurHook < NumScanHooks; CurHook++) {
+            ScanHooks[CurHook]();
         }
     }
-    //if pins are changed add pins
-    if (PinsToAdd | PinsToRemove) {
-        AD_SetPins();
+    //undervoltage is graded outside the interrupt by the Battery service
+    WindowScans += Config->Scans;
+    WindowInterrupts++;
+    Now = _CP0_GET_COUNT();
+    WindowBusy += Now - Entry;
+    if ((Now - WindowStart) >= RATE_WINDOW_TICKS) {
+        MeasuredRate = ((uint64_t) WindowScans * CORE_TICKS_PER_MS * 1000) / (Now - WindowStart);
+        InterruptRate = ((uint64_t) WindowInterrupts * CORE_TICKS_PER_MS * 1000) / (Now - WindowStart);
+        ISRLoad = ((uint64_t) WindowBusy * 1000) / (Now - WindowStart);
+        WindowScans = 0;
+        WindowInterrupts = 0;
+        WindowBusy = 0;
+        WindowStart = Now;
+    }
+    //pin or rate changes are applied between scans, the values just read are complete
+    if (Pending != NULL) {
+        AD_ApplyConfig();
     }
     ADNewData = TRUE;
 }
@@ -466,7 +728,7 @@ int main(void)
 //    mJTAGPortEnable(0);
     //MAXL:  MOVE THIS TO END AND FIX THE REST OF THIS TEST CODE
     while (1) {
-        printf("idling....waiting for sleep test: %d\n", AD_ReadADPin(BAT_VOLTAGE));
+        printf("idling....battery reading: %d\n", AD_ReadADPin(BAT_VOLTAGE));
         while (!IsTransmitEmpty());
     }
     //END MAXL
@@ -39,6 +39,11 @@
 #define BAT_VOLTAGE (1<<12)
 #define ROACH_LIGHT_SENSOR (1<<13)
 
+/**
+ * Function called from the A/D interrupt after every completed scan, see AD_AddScanHook
+ */
+typedef void (*AD_ScanHook_t)(void);
+
 
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
@@ -104,4 +109,77 @@ unsigned int AD_ReadADPin(unsigned int Pin);
  * @author Max Dunne, 2013.09.20 */
 void AD_End(void);
 
+/**
+ * @function AD_AddScanHook(AD_ScanHook_t Hook)
+ * @param Hook - function to be called from the A/D interrupt after every scan
+ * @return SUCCESS or ERROR
+ * @brief Registers a function that runs inside the A/D interrupt once the buffer of the
+ *        latest scan has been copied, so AD_ReadADPin returns the new values. Used by
+ *        drivers that need every sample of a channel rather than the latest one.
+ * @note Hooks run at interrupt priority, keep them short and do not print from them. */
+char AD_AddScanHook(AD_ScanHook_t Hook);
+
+/**
+ * @function AD_GetScanRate(void)
+ * @param None
+ * @return number of complete scans (samples per pin) each second
+ * @brief Every active pin is sampled once per scan, so this is also the sample rate seen
+ *        by a scan hook. It changes whenever pins are added or removed or the sample
+ *        rate is set. */
+unsigned int AD_GetScanRate(void);
+
+/**
+ * @function AD_SetSampleRate(unsigned int SamplesPerSecond)
+ * @param SamplesPerSecond - wanted samples per second on each active pin, 0 for the
+ *        original fixed timing (about 9345 points/s shared between the active pins)
+ * @return SUCCESS or ERROR
+ * @brief Sets the A/D sample and conversion times for this rate. They are picked again
+ *        whenever pins are added or removed, so the per pin rate holds. The rate is
+ *        clamped to what the A/D can do, AD_GetScanRate returns the rate actually used. */
+char AD_SetSampleRate(unsigned int SamplesPerSecond);
+
+/**
+ * @function AD_GetMeasuredScanRate(void)
+ * @param None
+ * @return scans per second counted in the A/D interrupt over the last quarter second */
+unsigned int AD_GetMeasuredScanRate(void);
+
+/**
+ * @function AD_GetReconfigureTicks(void)
+ * @param None
+ * @return the longest time, in core timer ticks (25 ns), that the A/D interrupt has
+ *         spent applying a pin or rate change
+ * @brief Pin and rate changes are worked out by the caller and only written to the A/D
+ *        by the interrupt between scans, this is the cost of that write. */
+unsigned int AD_GetReconfigureTicks(void);
+
+/**
+ * @function AD_SetBatching(unsigned char Enable)
+ * @param Enable - TRUE to read several scans per interrupt
+ * @return SUCCESS or ERROR
+ * @brief Splits the A/D buffer into two alternating halves (BUFM) and interrupts once a
+ *        half is full, every 8 / N scans with N active pins. Scan hooks still see every
+ *        scan. Off by default. */
+char AD_SetBatching(unsigned char Enable);
+
+/**
+ * @function AD_ReadADSum(unsigned int Pin, unsigned int *Samples)
+ * @param Pin - Used #defined AD_PORTxxx to select pin
+ * @param Samples - set to the number of samples in the sum
+ * @return sum of every sample of the pin since the last call, and clears it */
+unsigned int AD_ReadADSum(unsigned int Pin, unsigned int *Samples);
+
+/**
+ * @function AD_GetISRLoad(void)
+ * @param None
+ * @return share of the CPU spent in the A/D interrupt, in tenths of a percent */
+unsigned int AD_GetISRLoad(void);
+
+/**
+ * @function AD_PrintDiagnostics(void)
+ * @param None
+ * @return None
+ * @brief Prints the scan mode, set and measured rates, interrupt rate and load */
+void AD_PrintDiagnostics(void);
+
 #endif
@@ -9,6 +9,9 @@
 #include "AD.h"
 #include "IO_Ports.h"
 #include "pwm.h"
+#include "AnalogTapeSensors.h"
+#include "Params.h"
+#include "SensorHealth.h"
 
 #include <xc.h>
 #include <stdio.h>
@@ -18,8 +21,65 @@
 #define FRONTLEFTSENSOR AD_PORTW6
 #define FRONTRIGHTSENSOR AD_PORTW5
 
+//defaults were tuned with an open reading at full scale
+#define TAPE_FULL_SCALE 1023
+#define TAPE_CAL_BUDGET_MS 250
+#define TAPE_CAL_SETTLE_SCANS 4     //scans thrown away after the pins are added
+#define TAPE_CAL_SAMPLES 64
+#define TAPE_CAL_MIN_SAMPLES 16
+#define TAPE_CAL_MIN_OPEN 600       //lower than this and something is in view
+#define TAPE_CAL_MAX_NOISE 40       //standard deviation in counts
+#define TAPE_CAL_NOISE_SIGMAS 4     //far threshold is kept this far under the open reading
+#define TAPE_MOD_SETTLE_SCANS 1     //scans thrown away after the emitter is switched
+
+#define TAPE_PARAM(Sensor, Level) (PARAM_TAPE_THRESHOLD + ((Sensor) * NUM_TAPE_LEVELS) + (Level))
+
+static const unsigned int TapePins[NUM_ANALOG_TAPE] = {
+    LEFTSENSOR, RIGHTSENSOR, FRONTLEFTSENSOR, FRONTRIGHTSENSOR
+};
+
+//sensor on the same side that stands in for a faulted one
+static const unsigned char Partner[NUM_ANALOG_TAPE] = {
+    ANALOG_TAPE_FL, ANALOG_TAPE_FR, ANALOG_TAPE_L, ANALOG_TAPE_R
+};
+
+static const uint16_t DefaultThresholds[NUM_ANALOG_TAPE][NUM_TAPE_LEVELS] = {
+    {250, 350, 450, 800},
+    {250, 350, 450, 1000},
+    {250, 350, 450, 800},
+    {250, 350, 450, 800},
+};
+
+static uint16_t Thresholds[NUM_ANALOG_TAPE][NUM_TAPE_LEVELS];
+
+//modulated mode, only touched by the scan hook once Modulated is set
+static volatile unsigned char Modulated = FALSE;
+static unsigned char HookAdded = FALSE;
+static int8_t EmitterPort;
+static uint16_t EmitterPin;
+static unsigned char EmitterOn;
+static unsigned char PhaseScans;
+static uint16_t OnSample[NUM_ANALOG_TAPE];
+static uint16_t OffSample[NUM_ANALOG_TAPE];
+static volatile uint16_t Reflected[NUM_ANALOG_TAPE];
+
+static uint16_t Analog_TapeSqrt(uint32_t Value);
+static void Analog_TapeScanHook(void);
+
 unsigned char Analog_TapeInit(void){
     
+    unsigned char i, j;
+    
+    //stored calibration wins over the defaults
+    for (i = 0; i < NUM_ANALOG_TAPE; i++){
+        for (j = 0; j < NUM_TAPE_LEVELS; j++){
+            if (Params_IsSet(TAPE_PARAM(i, j))){
+                Thresholds[i][j] = Params_Get(TAPE_PARAM(i, j));
+            } else {
+                Thresholds[i][j] = DefaultThresholds[i][j];
+            }
+        }
+    }
     AD_Init();
     return AD_AddPins(LEFTSENSOR | RIGHTSENSOR | FRONTLEFTSENSOR | FRONTRIGHTSENSOR );   
     
@@ -27,25 +87,244 @@ unsigned char Analog_TapeInit(void){
 
 uint16_t Analog_TapeRead_L(void){
     
-    return AD_ReadADPin(LEFTSENSOR);
+    return Analog_TapeRead(ANALOG_TAPE_L);
     
 }
 
 uint16_t Analog_TapeRead_R(void){
     
-    return AD_ReadADPin(RIGHTSENSOR);
+    return Analog_TapeRead(ANALOG_TAPE_R);
     
 }
 
 uint16_t Analog_TapeRead_FL(void){
     
-    return AD_ReadADPin(FRONTLEFTSENSOR);
+    return Analog_TapeRead(ANALOG_TAPE_FL);
     
 }
 
 uint16_t Analog_TapeRead_FR(void){
     
-    return AD_ReadADPin(FRONTRIGHTSENSOR);
+    return Analog_TapeRead(ANALOG_TAPE_FR);
+    
+}
+
+uint16_t Analog_TapeRead(unsigned char Sensor){
+    
+    if (Sensor >= NUM_ANALOG_TAPE){
+        return 0;
+    }
+    if (Modulated){
+        return Reflected[Sensor];
+    }
+    return AD_ReadADPin(TapePins[Sensor]);
     
 }
 
+uint16_t Analog_TapeGetThreshold(unsigned char Sensor, unsigned char Level){
+    
+    if ((Sensor >= NUM_ANALOG_TAPE) || (Level >= NUM_TAPE_LEVELS)){
+        return 0;
+    }
+    return Thresholds[Sensor][Level];
+    
+}
+
+unsigned char Analog_TapeIsWithin(unsigned char Sensor, unsigned char Level){
+    
+    Sensor = Analog_TapeGetSource(Sensor);
+    return Analog_TapeRead(Sensor) < Analog_TapeGetThreshold(Sensor, Level);
+    
+}
+
+unsigned char Analog_TapeGetSource(unsigned char Sensor){
+    
+    if (Sensor >= NUM_ANALOG_TAPE){
+        return Sensor;
+    }
+    if (!SensorHealth_IsHealthy(Sensor) && SensorHealth_IsHealthy(Partner[Sensor])){
+        return Partner[Sensor];
+    }
+    return Sensor;
+    
+}
+
+unsigned char Analog_TapeIsCalibrated(void){
+    unsigned char i;
+    
+    for (i = 0; i < (NUM_ANALOG_TAPE * NUM_TAPE_LEVELS); i++){
+        if (!Params_IsSet(PARAM_TAPE_THRESHOLD + i)){
+            return FALSE;
+        }
+    }
+    return TRUE;
+    
+}
+
+char Analog_TapeCalibrate(void){
+    static const char * const Names[NUM_ANALOG_TAPE] = {"L", "R", "FL", "FR"};
+    uint32_t Sum[NUM_ANALOG_TAPE] = {0};
+    uint32_t SumSq[NUM_ANALOG_TAPE] = {0};
+    uint32_t Start = _CP0_GET_COUNT();
+    uint32_t Budget = TAPE_CAL_BUDGET_MS * CORE_TICKS_PER_MS;
+    uint16_t Samples = 0;
+    uint16_t Settle = 0;
+    uint16_t Reading, Mean, Noise, Far;
+    char Result = SUCCESS;
+    unsigned char i, j;
+    
+    //one sample of every sensor per A/D scan, stop at the sample count or the budget
+    while ((Samples < TAPE_CAL_SAMPLES) && ((_CP0_GET_COUNT() - Start) < Budget)){
+        if (!AD_IsNewDataReady()){
+            continue;
+        }
+        if (Settle < TAPE_CAL_SETTLE_SCANS){
+            Settle++;
+            continue;
+        }
+        for (i = 0; i < NUM_ANALOG_TAPE; i++){
+            Reading = Analog_TapeRead(i);
+            Sum[i] += Reading;
+            SumSq[i] += (uint32_t) Reading * Reading;
+        }
+        Samples++;
+    }
+    printf("Tape calibration: %u samples in %lu ms\r\n", Samples,
+            (unsigned long) ((_CP0_GET_COUNT() - Start) / CORE_TICKS_PER_MS));
+    if (Samples < TAPE_CAL_MIN_SAMPLES){
+        printf("Tape calibration: not enough samples, using defaults\r\n");
+        return ERROR;
+    }
+    
+    for (i = 0; i < NUM_ANALOG_TAPE; i++){
+        Mean = Sum[i] / Samples;
+        //n*sum(x^2) - sum(x)^2 keeps the rounding of the mean out of the variance
+        Noise = Analog_TapeSqrt((((uint64_t) SumSq[i] * Samples) - ((uint64_t) Sum[i] * Sum[i])) / ((uint32_t) Samples * Samples));
+        printf("  %-2s open %4u noise %3u: ", Names[i], Mean, Noise);
+        if (Mean < TAPE_CAL_MIN_OPEN){
+            printf("wall in view, ");
+            Result = ERROR;
+        } else if (Noise > TAPE_CAL_MAX_NOISE){
+            printf("too noisy, ");
+            Result = ERROR;
+        } else {
+            //scale the defaults to this sensor's open reading, keeping far clear of the noise
+            for (j = 0; j < NUM_TAPE_LEVELS; j++){
+                Thresholds[i][j] = ((uint32_t) DefaultThresholds[i][j] * Mean) / TAPE_FULL_SCALE;
+            }
+            Far = Mean - (TAPE_CAL_NOISE_SIGMAS * Noise);
+            if (Thresholds[i][TAPE_FAR] > Far){
+                Thresholds[i][TAPE_FAR] = Far;
+            }
+            for (j = 0; j < NUM_TAPE_LEVELS; j++){
+                Params_Set(TAPE_PARAM(i, j), Thresholds[i][j]);
+            }
+        }
+        printf("contact %u in range %u close %u far %u\r\n", Thresholds[i][TAPE_CONTACT],
+                Thresholds[i][TAPE_INRANGE], Thresholds[i][TAPE_CLOSE], Thresholds[i][TAPE_FAR]);
+    }
+    return Result;
+    
+}
+
+char Analog_TapeEnableModulation(int8_t Port, uint16_t Pin){
+    unsigned char i;
+    
+    if (Modulated){
+        return ERROR;
+    }
+    if (IO_PortsSetPortOutputs(Port, Pin) == ERROR){
+        return ERROR;
+    }
+    if (!HookAdded){
+        if (AD_AddScanHook(Analog_TapeScanHook) == ERROR){
+            return ERROR;
+        }
+        HookAdded = TRUE;
+    }
+    //the emitter is switched from the interrupt, so each interrupt has to be one scan
+    AD_SetBatching(FALSE);
+    EmitterPort = Port;
+    EmitterPin = Pin;
+    for (i = 0; i < NUM_ANALOG_TAPE; i++){
+        Reflected[i] = AD_ReadADPin(TapePins[i]);
+    }
+    EmitterOn = TRUE;
+    IO_PortsSetPortBits(EmitterPort, EmitterPin);
+    PhaseScans = 0;
+    Modulated = TRUE;
+    return SUCCESS;
+    
+}
+
+void Analog_TapeDisableModulation(void){
+    
+    if (!Modulated){
+        return;
+    }
+    Modulated = FALSE;
+    IO_PortsSetPortBits(EmitterPort, EmitterPin);
+    
+}
+
+unsigned char Analog_TapeIsModulated(void){
+    
+    return Modulated;
+    
+}
+
+/**
+ * @function Analog_TapeScanHook(void)
+ * @brief Called from the A/D interrupt after each scan. The scan running when the
+ *        emitter is switched straddles the change and is thrown away, the next one is
+ *        kept as the on or off sample. Each off sample completes a pair, and the
+ *        reading becomes full scale less the drop the emitter alone caused. */
+static void Analog_TapeScanHook(void){
+    unsigned char i;
+    
+    if (!Modulated){
+        return;
+    }
+    if (++PhaseScans <= TAPE_MOD_SETTLE_SCANS){
+        return;
+    }
+    for (i = 0; i < NUM_ANALOG_TAPE; i++){
+        if (EmitterOn){
+            OnSample[i] = AD_ReadADPin(TapePins[i]);
+        } else {
+            OffSample[i] = AD_ReadADPin(TapePins[i]);
+            //readings drop with more light, ambient is in both samples and cancels
+            if (OffSample[i] > OnSample[i]){
+                Reflected[i] = TAPE_FULL_SCALE - (OffSample[i] - OnSample[i]);
+            } else {
+                Reflected[i] = TAPE_FULL_SCALE;
+            }
+        }
+    }
+    EmitterOn = !EmitterOn;
+    if (EmitterOn){
+        IO_PortsSetPortBits(EmitterPort, EmitterPin);
+    } else {
+        IO_PortsClearPortBits(EmitterPort, EmitterPin);
+    }
+    PhaseScans = 0;
+}
+
+static uint16_t Analog_TapeSqrt(uint32_t Value){
+    uint32_t Root = 0;
+    uint32_t Bit = (uint32_t) 1 << 30;
+
+    while (Bit > Value) {
+        Bit >>= 2;
+    }
+    while (Bit != 0) {
+        if (Value >= Root + Bit) {
+            Value -= Root + Bit;
+            Root = (Root >> 1) + Bit;
+        } else {
+            Root >>= 1;
+        }
+        Bit >>= 2;
+    }
+    return Root;
+}
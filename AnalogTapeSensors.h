@@ -12,10 +12,93 @@
 #include <xc.h>
 #include <stdio.h>
 
+//sensors, for Analog_TapeRead and the threshold table
+#define ANALOG_TAPE_L 0
+#define ANALOG_TAPE_R 1
+#define ANALOG_TAPE_FL 2
+#define ANALOG_TAPE_FR 3
+#define NUM_ANALOG_TAPE 4
+
+//threshold levels, readings drop as the wall gets closer
+#define TAPE_CONTACT 0      //wall follower tracking distance
+#define TAPE_INRANGE 1      //wall in range events
+#define TAPE_CLOSE 2        //steering corrections while driving along a wall
+#define TAPE_FAR 3          //wall far events
+#define NUM_TAPE_LEVELS 4
+
 unsigned char Analog_TapeInit(void);
 
 uint16_t Analog_TapeRead_L(void);
 uint16_t Analog_TapeRead_R(void);
 
 uint16_t Analog_TapeRead_FL(void);
-uint16_t Analog_TapeRead_FR(void);
\ No newline at end of file
+uint16_t Analog_TapeRead_FR(void);
+
+uint16_t Analog_TapeRead(unsigned char Sensor);
+
+/**
+ * @function Analog_TapeGetThreshold(unsigned char Sensor, unsigned char Level)
+ * @param Sensor - ANALOG_TAPE_x
+ * @param Level - TAPE_x threshold level
+ * @return threshold in A/D counts, 0 for a bad sensor or level
+ * @brief Thresholds start at the compiled defaults and are replaced by
+ *        Analog_TapeCalibrate */
+uint16_t Analog_TapeGetThreshold(unsigned char Sensor, unsigned char Level);
+
+/**
+ * @function Analog_TapeIsWithin(unsigned char Sensor, unsigned char Level)
+ * @param Sensor - ANALOG_TAPE_x
+ * @param Level - TAPE_x threshold level
+ * @return TRUE if the sensor reads closer than the Level threshold
+ * @brief Replaces the open coded Analog_TapeRead_x() < 450 style comparisons */
+unsigned char Analog_TapeIsWithin(unsigned char Sensor, unsigned char Level);
+
+/**
+ * @function Analog_TapeGetSource(unsigned char Sensor)
+ * @param Sensor - ANALOG_TAPE_x
+ * @return the sensor to read in place of Sensor: Sensor itself while it is healthy,
+ *         otherwise the sensor at the other end of the same side if that one is
+ *         healthy. Analog_TapeIsWithin and the wall events go through it, so a loose
+ *         sensor degrades to its partner instead of stalling the run. */
+unsigned char Analog_TapeGetSource(unsigned char Sensor);
+
+/**
+ * @function Analog_TapeIsCalibrated(void)
+ * @return TRUE if every threshold was loaded from the parameter store */
+unsigned char Analog_TapeIsCalibrated(void);
+
+/**
+ * @function Analog_TapeCalibrate(void)
+ * @return SUCCESS if every sensor was calibrated, ERROR if any kept its defaults
+ * @brief Samples every sensor for at most TAPE_CAL_BUDGET_MS with no wall in view
+ *        and scales the thresholds to each sensor's open reading. A sensor that reads
+ *        too low (something in view) or too noisy keeps its defaults. The result for
+ *        each sensor is printed and stored with Params_Set, so later boots load it
+ *        in Analog_TapeInit. Call after all A/D pins have been added. */
+char Analog_TapeCalibrate(void);
+
+/**
+ * @function Analog_TapeEnableModulation(int8_t Port, uint16_t Pin)
+ * @param Port - PORTx the emitter drive is on
+ * @param Pin - IO_Ports pattern of the emitter pin
+ * @return SUCCESS or ERROR
+ * @brief Switches the emitters on and off on alternate A/D scans from a scan hook, and
+ *        takes the off reading less the on reading of each sensor, so ambient light
+ *        cancels. Analog_TapeRead then returns TAPE_FULL_SCALE less that difference,
+ *        which keeps the thresholds meaning the same thing: the reading drops as the wall
+ *        gets closer. Nothing runs outside the A/D interrupt.
+ * @note A reading takes four scans (two are thrown away while the emitter settles).
+ *       A/D batching is turned off. Run Analog_TapeCalibrate again after changing
+ *       mode, since the open reading moves by the ambient level */
+char Analog_TapeEnableModulation(int8_t Port, uint16_t Pin);
+
+/**
+ * @function Analog_TapeDisableModulation(void)
+ * @return None
+ * @brief Back to the raw readings, the emitter is left on */
+void Analog_TapeDisableModulation(void);
+
+/**
+ * @function Analog_TapeIsModulated(void)
+ * @return TRUE while the ambient rejecting mode is on */
+unsigned char Analog_TapeIsModulated(void);
@@ -51,7 +51,7 @@
  ******************************************************************************/
 #define BATTERY_DISCONNECT_THRESHOLD 175
 
-#define LRSWITCH PORTZ11_BIT
+#define LRSWITCH PIN11  //PORTZ
 
 /*******************************************************************************
  * EVENTCHECKER_TEST SPECIFIC CODE                                                             *
@@ -62,6 +62,7 @@
  ******************************************************************************/
 /* Prototypes for private functions for this EventChecker. They should be functions
    relevant to the behavior of this particular event checker */
+static uint16_t EdgeTime(int8_t Port, uint16_t Pin);
 
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                    *
@@ -71,181 +72,127 @@
    events would be placed here. Private variables should be STATIC so that they
    are limited in scope to this module. */
 
+typedef struct {
+    uint16_t Pin;
+    ES_EventTyp_t Tripped;
+    ES_EventTyp_t Untripped;
+} DigitalInput_t;
+
+typedef struct {
+    unsigned char Sensor;
+    ES_EventTyp_t InRange;
+    ES_EventTyp_t Far;
+    unsigned char Persist;  //passes a new level has to hold before it is posted
+} AnalogWall_t;
+
+//wall sensors checked by CheckAnalogTape, thresholds come from AnalogTapeSensors
+static const AnalogWall_t AnalogWallInputs[NUM_ANALOG_TAPE] = {
+    {ANALOG_TAPE_R, BACK_RIGHT_WALL_INRANGE, BACK_RIGHT_WALL_FAR, 0},
+    {ANALOG_TAPE_L, BACK_LEFT_WALL_INRANGE, BACK_LEFT_WALL_FAR, 4},
+    {ANALOG_TAPE_FR, FRONT_RIGHT_WALL_INRANGE, FRONT_RIGHT_WALL_FAR, 0},
+    {ANALOG_TAPE_FL, FRONT_LEFT_WALL_INRANGE, FRONT_LEFT_WALL_FAR, 0},
+};
+
+//PORTX inputs sampled by CheckDigitalTape, one event per changed pin
+static const DigitalInput_t DigitalTapeInputs[] = {
+    {TAPESENSOR_F, FRONT_TAPE_TRIPPED, FRONT_TAPE_UNTRIPPED},
+    {TAPESENSOR_B, BACK_TAPE_TRIPPED, BACK_TAPE_UNTRIPPED},
+};
+
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                            *
  ******************************************************************************/
 
+/**
+ * @function CheckDigitalTape(void)
+ * @return TRUE if any tape edge was posted
+ * @brief Diffs the debounced PORTX word of the IO snapshot against the last one and
+ *        posts an event for every tape pin that changed, so a front and back edge in
+ *        the same tick are both reported. EventParam is the ES_Timer_GetTime() of the
+ *        edge (low 16 bits), taken from the change notify timestamp. */
 uint8_t CheckDigitalTape(void){
-    static ES_EventTyp_t lastEvent = ES_NO_EVENT;
-    ES_EventTyp_t curEvent;
+    static uint16_t PrevTapeVal;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
+    uint16_t TapeVal;
+    uint16_t Changed;
+    uint16_t Pin;
+    unsigned char i;
     
-    unsigned char TapeVal;
-    static unsigned char PrevTapeVal;
-    
-    TapeVal =  Read_DigitalTape();
+    TapeVal = IO_PortsGetSnapshot()->debounced[PORTX];
+    Changed = (TapeVal ^ PrevTapeVal) & (TAPESENSOR_F | TAPESENSOR_B);
+    PrevTapeVal = TapeVal;
     
-    if ((TapeVal & 0b10) != (PrevTapeVal & 0b10)){
-        if (TapeVal & 0b10){
-            curEvent = FRONT_TAPE_TRIPPED;
-        } else {
-             curEvent = FRONT_TAPE_UNTRIPPED;
+    while (Changed){
+        Pin = Changed & -Changed; //lowest changed pin
+        Changed &= ~Pin;
+        for (i = 0; i < (sizeof(DigitalTapeInputs) / sizeof(DigitalTapeInputs[0])); i++){
+            if (DigitalTapeInputs[i].Pin == Pin){
+                thisEvent.EventType = (TapeVal & Pin) ? DigitalTapeInputs[i].Tripped : DigitalTapeInputs[i].Untripped;
+                thisEvent.EventParam = EdgeTime(PORTX, Pin);
+                PostBdayFSM(thisEvent);
+                //PostTESTEventService(thisEvent);
+                returnVal = TRUE;
+            }
         }
     }
     
-    if ((TapeVal & 0b1) != (PrevTapeVal & 0b1)){
-        if (TapeVal & 0b1){
-            curEvent = BACK_TAPE_TRIPPED;
-        } else {
-             curEvent = BACK_TAPE_UNTRIPPED;
-        }
-    }
-
-    if (curEvent != lastEvent){
-        thisEvent.EventType = curEvent;
-        returnVal = TRUE;
-        lastEvent = curEvent;  
-        PostBdayFSM(thisEvent);
-        //PostTESTEventService(thisEvent);
-    }
-    
-    PrevTapeVal = TapeVal;
     return returnVal;
 }
 
 unsigned char CheckAnalogTape(void){
     
-    static ES_EventTyp_t lastEvent_L = ES_NO_EVENT;
-    static ES_EventTyp_t lastEvent_R = ES_NO_EVENT;
-    static ES_EventTyp_t lastEvent_FL = ES_NO_EVENT;
-    static ES_EventTyp_t lastEvent_FR = ES_NO_EVENT;
-    ES_EventTyp_t curEvent_L;
-    ES_EventTyp_t curEvent_R;
-    ES_EventTyp_t curEvent_FL;
-    ES_EventTyp_t curEvent_FR;
-    
-    
+    static ES_EventTyp_t lastEvent[NUM_ANALOG_TAPE] = {ES_NO_EVENT, ES_NO_EVENT, ES_NO_EVENT, ES_NO_EVENT};
+    static ES_EventTyp_t pendingEvent[NUM_ANALOG_TAPE];
+    static unsigned char pendingCount[NUM_ANALOG_TAPE];
+    ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
-    
-    uint16_t AnalogTapeReadRight;
-    uint16_t AnalogTapeReadLeft;
-    uint16_t AnalogTapeReadFrontRight;
-    uint16_t AnalogTapeReadFrontLeft;
-
-    AnalogTapeReadRight =  Analog_TapeRead_R();    
-    AnalogTapeReadLeft = Analog_TapeRead_L();
-    AnalogTapeReadFrontRight =  Analog_TapeRead_FR();    
-    AnalogTapeReadFrontLeft = Analog_TapeRead_FL();
-    //printf("Left Tape Reading is: %d", AnalogTapeReadFrontLeft);
-    //printf("Back Tape: %d\r\n", AnalogTapeReadRight);
-    if (AnalogTapeReadRight < 350){
-        curEvent_R = BACK_RIGHT_WALL_INRANGE;    
-    } 
-    else if (AnalogTapeReadRight > 1000){
-        curEvent_R = BACK_RIGHT_WALL_FAR;
-    } 
-    else {
-        curEvent_R = lastEvent_R;
-    }
-    
-    if (curEvent_R != lastEvent_R){
-        lastEvent_R = curEvent_R;
-        thisEvent.EventType = curEvent_R;
-        //PostTESTEventService(thisEvent);
-        PostBdayFSM(thisEvent);
-        returnVal = TRUE;
-    }
-    
-    static unsigned char lastvalBL;
-    unsigned char curvalBL;
-    static int iBL;
-    
-    if (AnalogTapeReadLeft < 350){
-        curvalBL = BACK_LEFT_WALL_INRANGE;       
-    } 
-    else if (AnalogTapeReadLeft > 800){
-        curvalBL = BACK_LEFT_WALL_FAR;
-    } 
-    
-    if (curvalBL == lastvalBL){
-        iBL++;
-    } 
-    else {
-        iBL = 0;
-    }
-    
-    if (iBL > 3) {
-        curEvent_L = curvalBL;
-    }    
-    
-    if (curEvent_L != lastEvent_L){
-        lastEvent_L = curEvent_L;
-        thisEvent.EventType = curEvent_L;
-        PostBdayFSM(thisEvent);
-        //PostTESTEventService(thisEvent);
-        returnVal = TRUE;
-    }
-    
-    lastvalBL = curvalBL;
-    
-    //FRONT TAPE SENSORS CHECK
-    if (AnalogTapeReadFrontRight < 350){
-        curEvent_FR = FRONT_RIGHT_WALL_INRANGE;    
-    } 
-    else if (AnalogTapeReadFrontRight > 800){
-        curEvent_FR = FRONT_RIGHT_WALL_FAR;
-    } 
-    else {
-        curEvent_FR = lastEvent_FR;
-    }
-    
-    if (curEvent_FR != lastEvent_FR){
-        lastEvent_FR = curEvent_FR;
-        thisEvent.EventType = curEvent_FR;
-        //PostTESTEventService(thisEvent);
-        PostBdayFSM(thisEvent);
-        returnVal = TRUE;
-    }
-
-    if (AnalogTapeReadFrontLeft < 350){
-        curEvent_FL = FRONT_LEFT_WALL_INRANGE;       
-    } else if (AnalogTapeReadFrontLeft > 800){
-        curEvent_FL = FRONT_LEFT_WALL_FAR;
-    } else {
-        curEvent_FL = lastEvent_FL;
+    uint16_t Reading;
+    const AnalogWall_t *Wall;
+    unsigned char i, Source;
+    
+    for (i = 0; i < NUM_ANALOG_TAPE; i++){
+        Wall = &AnalogWallInputs[i];
+        Source = Analog_TapeGetSource(Wall->Sensor);
+        Reading = Analog_TapeRead(Source);
+        //printf("Tape %d reading is: %d\r\n", Wall->Sensor, Reading);
+        if (Reading < Analog_TapeGetThreshold(Source, TAPE_INRANGE)){
+            curEvent = Wall->InRange;
+        } else if (Reading > Analog_TapeGetThreshold(Source, TAPE_FAR)){
+            curEvent = Wall->Far;
+        } else {
+            curEvent = pendingEvent[i];
+        }
+        
+        if (curEvent == pendingEvent[i]){
+            if (pendingCount[i] < Wall->Persist){
+                pendingCount[i]++;
+            }
+        } else {
+            pendingEvent[i] = curEvent;
+            pendingCount[i] = 0;
+        }
+        
+        if ((pendingCount[i] >= Wall->Persist) && (curEvent != lastEvent[i]) && (curEvent != ES_NO_EVENT)){
+            lastEvent[i] = curEvent;
+            thisEvent.EventType = curEvent;
+            PostBdayFSM(thisEvent);
+            //PostTESTEventService(thisEvent);
+            returnVal = TRUE;
+        }
     }
     
-    if (curEvent_FL != lastEvent_FL){
-        lastEvent_FL = curEvent_FL;
-        thisEvent.EventType = curEvent_FL;
-        PostBdayFSM(thisEvent);
-        //PostTESTEventService(thisEvent);
-        returnVal = TRUE;
-    }   
+    return returnVal;
 }
 
 uint8_t CheckBumpers(void){
     
-    uint8_t Bumper_Curr_Reading = BumperRead();
-    static unsigned char Bumper_Prev_Reading;
-    
-    uint8_t returnVal = FALSE;
-    
-    static unsigned int i;
-    static unsigned char Bumper_Curr_Event;
+    //debounced in IO_Ports from the change notify edges, so a change is a real contact
+    uint8_t Bumper_Curr_Event = BumperRead();
     static unsigned char Bumper_Prev_Event = 0;
-
-    if (Bumper_Curr_Reading == Bumper_Prev_Reading){
-        i++;        
-    } else {
-        i = 0;
-    }
     
-    if (i >= 10) {
-        Bumper_Curr_Event = Bumper_Curr_Reading;
-    }
+    uint8_t returnVal = FALSE;
     
     if (Bumper_Curr_Event != Bumper_Prev_Event){
         ES_Event thisEvent;
@@ -257,7 +204,6 @@ uint8_t CheckBumpers(void){
         returnVal = TRUE;
     }
     
-    Bumper_Prev_Reading = Bumper_Curr_Reading;
     return returnVal;    
 }
 
@@ -267,24 +213,17 @@ unsigned char CheckTrackWire(void){
     ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
-    static unsigned int i;
     
-    unsigned char Reading = ReadTrackWire();
-    
-    if (Reading){
-        i++;
-        if (i == 3){
-            curEvent = ON_WIRE;
-        } else {
-            curEvent = OFF_WIRE;
-        }
+    //input capture only reports the wire once the carrier is in band
+    if (ReadTrackWire()){
+        curEvent = ON_WIRE;
     } else {
-        i = 0;
         curEvent = OFF_WIRE;
     }
     
     if (curEvent != lastEvent){
         thisEvent.EventType = curEvent;
+        thisEvent.EventParam = TrackWire_GetFrequency();
         returnVal = TRUE;
         lastEvent = curEvent;  
         PostBdayFSM(thisEvent);
@@ -294,35 +233,64 @@ unsigned char CheckTrackWire(void){
     return returnVal;    
 }
 
+unsigned char CheckTurnstile(void){
+    
+    static uint8_t lastMoving = FALSE;
+    uint8_t curMoving;
+    ES_Event thisEvent;
+    uint8_t returnVal = FALSE;
+    
+    //a move takes at least one 20ms servo frame, so the 3ms tick always sees it
+    curMoving = Turnstile_IsMoving();
+    if (lastMoving && !curMoving){
+        thisEvent.EventType = TURNSTILE_ARRIVED;
+        thisEvent.EventParam = Turnstile_GetPosition();
+        returnVal = TRUE;
+        PostBdayFSM(thisEvent);
+    }
+    lastMoving = curMoving;
+    
+    return returnVal;    
+}
+
 unsigned char CheckBeacon(void){
     
     static ES_EventTyp_t lastEvent = ES_NO_EVENT;
     ES_EventTyp_t curEvent;
     ES_Event thisEvent;
     uint8_t returnVal = FALSE;
+    uint32_t PeakTime;
     
-    unsigned int Reading = ReadBeacon();
-    
-    if (Reading < 250){
+    //hysteresis is in Beacon.c, the Goertzel filter is not built in until W8 is rewired
+    if (Beacon_IsPresent()){
         curEvent = BEACON_PRESENT;
     } 
-    else if (Reading > 1000) {
+    else {
         curEvent = BEACON_ABSENT;
     }
     
     if (curEvent != lastEvent){
         thisEvent.EventType = curEvent;
+        thisEvent.EventParam = Beacon_GetStrength();
         returnVal = TRUE;
         lastEvent = curEvent;  
         PostBdayFSM(thisEvent);
         //PostTESTEventService(thisEvent);
     }
     
+    //report how long ago a sweep passed the beacon so the FSM can turn back onto it
+    if (Beacon_SweepPeak(&PeakTime)){
+        thisEvent.EventType = BEACON_BEARING;
+        thisEvent.EventParam = ES_Timer_GetTime() - PeakTime;
+        returnVal = TRUE;
+        PostBdayFSM(thisEvent);
+    }
+    
     return returnVal;    
 }
 
 unsigned char CheckSide(void){
-    return LRSWITCH;
+    return (IO_PortsGetSnapshot()->raw[PORTZ] & LRSWITCH) != 0;
 }
 /**
  * @Function TemplateCheckBattery(void)
@@ -364,6 +332,22 @@ uint8_t TemplateCheckBattery(void) {
     return (returnVal);
 }
 
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+/**
+ * @function EdgeTime(int8_t Port, uint16_t Pin)
+ * @param Port - PORTx the pin is on
+ * @param Pin - PINx that changed
+ * @return ES_Timer_GetTime() at the debounced edge, low 16 bits
+ * @brief Moves the core timer stamp of the edge onto the framework millisecond clock */
+static uint16_t EdgeTime(int8_t Port, uint16_t Pin){
+    uint32_t Age = (_CP0_GET_COUNT() - IO_PortsGetChangeTime(Port, Pin)) / CORE_TICKS_PER_MS;
+    
+    return ES_Timer_GetTime() - Age;
+}
+
 /* 
  * The Test Harness for the event checkers is conditionally compiled using
  * the EVENTCHECKER_TEST macro (defined either in the file or at the project level).
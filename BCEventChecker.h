@@ -8,5 +8,6 @@ unsigned char CheckAnalogTape(void);
 uint8_t CheckBumpers(void);
 unsigned char CheckTrackWire(void);
 unsigned char CheckBeacon(void);
+unsigned char CheckTurnstile(void);
 uint8_t TemplateCheckBattery(void);
 unsigned char CheckSide(void);
\ No newline at end of file
@@ -38,12 +38,16 @@
 #include "Motor_Driver.h"
 #include "AD.h"
 #include "pwm.h"
+#include "IO_Ports.h"
 #include "RC_Servo.h"
 #include "DigitalTapeSensors.h"
 #include "AnalogTapeSensors.h"
 #include "BumperSensor.h"
 #include "TrackWire.h"
 #include "Beacon.h"
+#include "Params.h"
+#include "WallController.h"
+#include "Flywheel.h"
 #include "Servo.h"
 #include "OnePointerSubHSM.h"
 #include "TwoPointerSubHSM.h"
@@ -60,6 +64,8 @@
  ******************************************************************************/
 
 #define BATTERY_DISCONNECT_THRESHOLD 175
+#define BATTERY_LOW_THROTTLE 75         //percent of the commanded drive speed
+#define BATTERY_CRITICAL_THROTTLE 50
 
 #define TAPE_SERVICE_TIMER 0
 #define TIMER_0_TICKS 3
@@ -79,6 +85,8 @@
 #define RETURN_TIMER 10
 //#define RETURN_TIMER_BR 12
 
+#define AIM_BEACON_TIMER 12
+
 #define FR 4
 #define FL 8
 #define BR 1
@@ -99,6 +107,7 @@
 typedef enum {
     Init,
     Find_Beacon,
+    Aim_Beacon,
     Find_Wall,
     Align_F,
     Align_R,     
@@ -115,12 +124,14 @@ typedef enum {
     Reverse_To_2PT,        
     Shoot_3PT,
     Go_to_Reload,        
-    Reload
+    Reload,
+    Tune
 } BdayFSMState_t;
 
 static const char *StateNames[] = {
 	"Init",
 	"Find_Beacon",
+	"Aim_Beacon",
 	"Find_Wall",
 	"Align_Wall",
 	"Pivot",
@@ -143,6 +154,7 @@ static unsigned char Direction;
 static unsigned char OnePoint;
 static unsigned char TwoPoint;
 static unsigned char ThreePoint;
+static unsigned char Tuning = FALSE;   //bumper held at power up, wait stopped for tuning
 unsigned char Side;
 
 
@@ -167,6 +179,7 @@ uint8_t InitBdayFSM(uint8_t Priority)
     // put us into the Initial PseudoState
     CurrentState = Init;
     
+    Params_Init();
     AD_Init();
     PWM_Init();
     RC_Init();
@@ -175,7 +188,17 @@ uint8_t InitBdayFSM(uint8_t Priority)
     Analog_TapeInit();
     Bumper_Init();
     Motors_Init();
+    Drive_SetRamp(DRIVE_ACCEL, DRIVE_DECEL);
     Beacon_Init();
+    TrackWire_Init();
+    //all A/D pins are in by now, robot has to be started with no wall in view.
+    //Hold a bumper at power up to recalibrate after a venue change, the robot then
+    //stays in Tune so parameters can be stored over serial until a bumper is pressed.
+    IO_PortsTakeSnapshot();
+    Tuning = BumperRead() ? TRUE : FALSE;
+    if (!Analog_TapeIsCalibrated() || Tuning){
+        Analog_TapeCalibrate();
+    }
     InitOnePointerSubHSM();
     //InitOPBSubHSM();
     InitTwoPointerSubHSM();
@@ -230,6 +253,8 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
     static unsigned char LastState;
     static unsigned char One_Point_Done = FALSE;
     static unsigned char Two_Point_Done = FALSE;
+    static unsigned char BatteryCritical = FALSE;
+    static unsigned char WallBlind[2] = {FALSE, FALSE};  //both sensors on a side faulted
     static uint32_t LastTime;
     static uint32_t CurrentTime;
     int i;
@@ -283,11 +308,16 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
     switch (ThisEvent.EventType){    
     case (ES_TIMEOUT):
             if (ThisEvent.EventParam == TAPE_SERVICE_TIMER){
+                IO_PortsTakeSnapshot();
+                CheckBumpers();
                 CheckDigitalTape();
+                Drive_RampTick();
+                Flywheel_Update();
                 CheckAnalogTape();
-                CheckBumpers();
                 CheckTrackWire();
                 CheckBeacon();
+                CheckTurnstile();
+                Params_CheckSerial((CurrentState == Tune) || (CurrentState == Test_Stop));
                 ES_Timer_InitTimer(TAPE_SERVICE_TIMER, TIMER_0_TICKS);
             }
 
@@ -308,6 +338,23 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             break;
         case(ES_TIMERSTOPPED):
             break;
+        case(BATTERY_LOW):
+            printf("Battery low, reading %d\r\n", ThisEvent.EventParam);
+            Motors_SetThrottle(BATTERY_LOW_THROTTLE);
+            break;
+        case(BATTERY_CRITICAL):
+            printf("Battery critical, reading %d\r\n", ThisEvent.EventParam);
+            Motors_SetThrottle(BATTERY_CRITICAL_THROTTLE);
+            BatteryCritical = TRUE;
+            break;
+        case(SENSOR_FAULT):
+            //with one sensor of a pair left the wall events and steering read through it,
+            //with neither there is nothing to follow that wall with
+            WallBlind[RIGHT] = !(ThisEvent.EventParam & ((1 << ANALOG_TAPE_FR) | (1 << ANALOG_TAPE_R)));
+            WallBlind[LEFT] = !(ThisEvent.EventParam & ((1 << ANALOG_TAPE_FL) | (1 << ANALOG_TAPE_L)));
+            printf("Wall sensors healthy mask 0x%x%s%s\r\n", ThisEvent.EventParam,
+                    WallBlind[RIGHT] ? ", right wall blind" : "", WallBlind[LEFT] ? ", left wall blind" : "");
+            break;
         default:
             break;
     }
@@ -316,7 +363,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
         
         
         case Init: // If current state is initial Psedudo State
-            CurrentState = Find_Beacon;
+            CurrentState = Tuning ? Tune : Find_Beacon;
 //            RightWheelSpeed(1000);
 //            LeftWheelSpeed(1000);
             break;
@@ -324,46 +371,56 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
         case Find_Beacon: // in the first state, replace this with appropriate state
             Two_Point_Done = FALSE;
             One_Point_Done = FALSE;
+            if (!Beacon_IsSweeping()){
+                Beacon_StartSweep();
+            }
             if (Side == RIGHT){
-                LeftWheelSpeed(1000);
-                RightWheelSpeed(-1000);
+                Drive_SetWheels(1000, -1000);
             } 
             else {
-                LeftWheelSpeed(-1000);
-                RightWheelSpeed(1000);
+                Drive_SetWheels(-1000, 1000);
             }
 
-            if (ThisEvent.EventType == BEACON_PRESENT){
+            //the sweep has rotated past the beacon, turn back onto the fitted peak
+            if (ThisEvent.EventType == BEACON_BEARING){
+                CurrentState = Aim_Beacon;
+                if (Side == RIGHT){
+                    Drive_SetWheels(-1000, 1000);
+                } 
+                else {
+                    Drive_SetWheels(1000, -1000);
+                }
+                ES_Timer_InitTimer(AIM_BEACON_TIMER, ThisEvent.EventParam ? ThisEvent.EventParam : 1);
+            }
+            break;
+
+        case Aim_Beacon:
+            if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == AIM_BEACON_TIMER)){
                 CurrentState = Find_Wall;
                 ES_Timer_InitTimer(TAPE_TIMER, TAPE_TICKS);
                 //LeftWheelSpeed(500);
                 //RightWheelSpeed(500);
-                LeftFlyWheelSpeed(-300);
-                RightFlyWheelSpeed(-300);
+                Flywheel_SetSpeed(Params_Get(PARAM_FLYWHEEL_SPEED));
                 
                 if (Side == RIGHT){
-                    if (Analog_TapeRead_FR() < 450){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_FR, TAPE_CLOSE)){
                         CurrentState = Pivot;
-                        RightWheelSpeed(300);
-                        LeftWheelSpeed(0);
+                        Drive_SetWheels(0, 300);
                         
-                        if (Analog_TapeRead_L() < 450){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
                             CurrentState = Follow_Wall;
-                            RightWheelSpeed(1000);
-                            LeftWheelSpeed(400);
+                            Drive_SetWheels(400, 1000);
                         }
                     }
                 } 
                 else if (Side == LEFT) {
-                    if (Analog_TapeRead_FL() < 450){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_FL, TAPE_CLOSE)){
                         CurrentState = Pivot;
-                        RightWheelSpeed(0);
-                        LeftWheelSpeed(300);
+                        Drive_SetWheels(300, 0);
                         
-                        if (Analog_TapeRead_L() < 450){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
                             CurrentState = Follow_Wall;
-                            RightWheelSpeed(400);
-                            LeftWheelSpeed(1000);
+                            Drive_SetWheels(1000, 400);
                         }
                     }
                 }
@@ -374,35 +431,29 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             
             if (Side == RIGHT){     
 
-                LeftWheelSpeed(400);
-                RightWheelSpeed(350);
+                Drive_SetWheels(400, 350);
                 
                 if (ThisEvent.EventType == FRONT_RIGHT_WALL_INRANGE){
                     CurrentState = Pivot;
-                    RightWheelSpeed(300);
-                    LeftWheelSpeed(0);
+                    Drive_SetWheels(0, 300);
                     
-                    if (Analog_TapeRead_R() < 450){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
                         CurrentState = Follow_Wall;
-                        RightWheelSpeed(1000);
-                        LeftWheelSpeed(400);
+                        Drive_SetWheels(400, 1000);
                     }
                 }
             } 
             else if (Side == LEFT){
                 
-                LeftWheelSpeed(400);
-                RightWheelSpeed(400);
+                Drive_SetWheels(400, 400);
                 
                 if (ThisEvent.EventType == FRONT_LEFT_WALL_INRANGE){
                     CurrentState = Pivot;
-                    RightWheelSpeed(0);
-                    LeftWheelSpeed(300);
+                    Drive_SetWheels(300, 0);
                     
-                    if (Analog_TapeRead_L() < 450){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
                         CurrentState = Follow_Wall;
-                        RightWheelSpeed(400);
-                        LeftWheelSpeed(1000);
+                        Drive_SetWheels(1000, 400);
                     }
                 }
             }
@@ -412,26 +463,22 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     //TapeFlag = FALSE;
                     Collision_Flag = TRUE;
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_R() < 450){
-                            RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                            Drive_SetWheels(-400, -1000);
                             CurrentState = Reverse_Wall;
                         } 
                         else {
-                           RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000);
+                            Drive_SetWheels(-1000, -400);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
                     } else if (Side == LEFT){
-                        if (Analog_TapeRead_L() < 450){
-                            RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                            Drive_SetWheels(-1000, -400);
                             CurrentState = Reverse_Wall;
                         } 
                         else {
-                           RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                            Drive_SetWheels(-400, -1000);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
@@ -449,13 +496,11 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     if (FRSensor){
                         CurrentState = Align_F;
                         LastState = Follow_Wall;
-                        RightWheelSpeed(400);
-                        LeftWheelSpeed(1000);
+                        Drive_SetWheels(1000, 400);
                     } 
                     else {
                         CurrentState = Follow_Wall;
-                        RightWheelSpeed(1000);
-                        LeftWheelSpeed(400);
+                        Drive_SetWheels(400, 1000);
                     }   
                 }
                 if (ThisEvent.EventType == FRONT_RIGHT_WALL_FAR){
@@ -467,13 +512,11 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     if (FLSensor){
                         CurrentState = Align_F;
                         LastState = Follow_Wall;
-                        RightWheelSpeed(1000);
-                        LeftWheelSpeed(400);
+                        Drive_SetWheels(400, 1000);
                     } 
                     else {
                         CurrentState = Follow_Wall;
-                        RightWheelSpeed(400);
-                        LeftWheelSpeed(1000);
+                        Drive_SetWheels(1000, 400);
                     }
                 }
                 if (ThisEvent.EventType == FRONT_LEFT_WALL_FAR){
@@ -486,26 +529,22 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     Collision_Flag = TRUE;
                     //TapeFlag = FALSE;
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_R() < 450){
-                            RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                            Drive_SetWheels(-400, -1000);
                             CurrentState = Reverse_Wall;
                         } 
                         else {
-                           RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000);
+                            Drive_SetWheels(-1000, -400);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
                     } else if (Side == LEFT){
-                        if (Analog_TapeRead_L() < 450){
-                            RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                            Drive_SetWheels(-1000, -400);
                             CurrentState = Reverse_Wall;
                         } 
                         else {
-                           RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                            Drive_SetWheels(-400, -1000);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
@@ -517,27 +556,14 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             if (ThisEvent.EventType == ES_TIMEOUT) {
                 if (ThisEvent.EventParam == BACK_WALL_FOLLOW_TIMER) {
                     CurrentState = Find_Beacon;
-                    LeftFlyWheelSpeed(0);
-                    RightFlyWheelSpeed(0);
+                    Flywheel_SetSpeed(0);
                 }
             }
             
             break;
          
         case Follow_Wall:     
-
-            if ((ThisEvent.EventType == FRONT_LEFT_WALL_FAR) && (Side == LEFT)){
-                LastState = CurrentState;
-                CurrentState = Align_F;
-                RightWheelSpeed(1000);
-                LeftWheelSpeed(400);
-            }
-            else if ((ThisEvent.EventType == FRONT_RIGHT_WALL_FAR) && (Side == RIGHT)){
-                LastState = CurrentState;
-                CurrentState = Align_F;
-                RightWheelSpeed(400);
-                LeftWheelSpeed(1000);
-            }  
+            // WallController steers while in this state, see the end of RunBdayFSM
 
             if ((ThisEvent.EventType == BACK_TAPE_TRIPPED) && (TapeFlag == TRUE)){
                     
@@ -548,8 +574,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             if (ThisEvent.EventType == ES_TIMEOUT) {
                 if (ThisEvent.EventParam == MOVE_FWD_TIMER) {
                     CurrentState = Shoot_1PT;
-                    LeftWheelSpeed(0);
-                    RightWheelSpeed(0);
+                    Drive_SetWheels(0, 0);
                 }
             }
             if (ThisEvent.EventType == BUMPER_BUMPED){
@@ -557,26 +582,22 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     Collision_Flag = TRUE;
                     
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_R() < 450){
-                            RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                            Drive_SetWheels(-400, -1000);
                             CurrentState = Reverse_Wall;
                         } 
                         else {
-                           RightWheelSpeed(-400);
-                           LeftWheelSpeed(-1000);  
+                           Drive_SetWheels(-1000, -400);
                            LastState = Reverse_Wall;
                            CurrentState = Align_R; 
                         }
                     } 
                     else if (Side == LEFT){
-                        if (Analog_TapeRead_L() < 450){
-                            RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                            Drive_SetWheels(-1000, -400);
                             CurrentState = Reverse_Wall;
                         } else {
-                            RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                            Drive_SetWheels(-400, -1000);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
@@ -587,8 +608,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             if (ThisEvent.EventType == ES_TIMEOUT) {
                 if (ThisEvent.EventParam == BACK_WALL_FOLLOW_TIMER) {
                     CurrentState = Find_Beacon;
-                    LeftFlyWheelSpeed(0);
-                    RightFlyWheelSpeed(0);
+                    Flywheel_SetSpeed(0);
                 } else if (ThisEvent.EventParam == RETURN_TIMER) {
                     CurrentState = Reload;
                     ES_Timer_InitTimer(RELOAD_TIMER, RELOAD_TICKS);
@@ -600,13 +620,11 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
         case Align_F:
 
             if (ThisEvent.EventType == FRONT_LEFT_WALL_INRANGE && Side == LEFT){
-                RightWheelSpeed(400);
-                LeftWheelSpeed(1000);
+                Drive_SetWheels(1000, 400);
                 CurrentState = LastState;
             }
             if (ThisEvent.EventType == FRONT_RIGHT_WALL_INRANGE && Side == RIGHT){
-                RightWheelSpeed(1000);
-                LeftWheelSpeed(400);
+                Drive_SetWheels(400, 1000);
                 CurrentState = LastState;
             }
             
@@ -619,15 +637,13 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             if (ThisEvent.EventType == ES_TIMEOUT) {
                 if (ThisEvent.EventParam == MOVE_FWD_TIMER) {
                     CurrentState = Shoot_1PT;
-                    LeftWheelSpeed(0);
-                    RightWheelSpeed(0);
+                    Drive_SetWheels(0, 0);
                 }
             }
             if (ThisEvent.EventType == ES_TIMEOUT) {
                 if (ThisEvent.EventParam == BACK_WALL_FOLLOW_TIMER) {
                     CurrentState = Find_Beacon;
-                    LeftFlyWheelSpeed(0);
-                    RightFlyWheelSpeed(0);
+                    Flywheel_SetSpeed(0);
                 } else if (ThisEvent.EventParam == RETURN_TIMER) {
                     CurrentState = Reload;
                     ES_Timer_InitTimer(RELOAD_TIMER, RELOAD_TICKS);
@@ -639,25 +655,21 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 if (ThisEvent.EventParam & (FR | FL)) {
                     Collision_Flag = TRUE;
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_R() < 450){
-                            RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                            Drive_SetWheels(-400, -1000);
                             CurrentState = Reverse_Wall;
                         } else {
-                           RightWheelSpeed(-400);
-                           LeftWheelSpeed(-1000); 
+                           Drive_SetWheels(-1000, -400);
                            LastState = Reverse_Wall;
                            CurrentState = Align_R; 
                         }
                     } 
                     else if (Side == LEFT){
-                        if (Analog_TapeRead_L() < 450){
-                            RightWheelSpeed(-400);
-                            LeftWheelSpeed(-1000); 
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                            Drive_SetWheels(-1000, -400);
                             CurrentState = Reverse_Wall;
                         } else {
-                           RightWheelSpeed(-1000);
-                            LeftWheelSpeed(-400); 
+                            Drive_SetWheels(-400, -1000);
                             LastState = Reverse_Wall;
                             CurrentState = Align_R; 
                         }
@@ -675,26 +687,22 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 One_Point_Done = TRUE;
                 //CurrentState = Reverse_To_2PT;
                 if (Side == RIGHT){
-                    if (Analog_TapeRead_R() < 450){
-                        RightWheelSpeed(-1000);
-                        LeftWheelSpeed(-400); 
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                        Drive_SetWheels(-400, -1000);
                         CurrentState = Reverse_Wall;
                     } 
                     else {
-                       RightWheelSpeed(-400);
-                        LeftWheelSpeed(-1000);
+                        Drive_SetWheels(-1000, -400);
                         LastState = Reverse_Wall;
                         CurrentState = Align_R; 
                     }
                 } else if (Side == LEFT){
-                    if (Analog_TapeRead_L() < 450){
-                        RightWheelSpeed(-400);
-                        LeftWheelSpeed(-1000); 
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                        Drive_SetWheels(-1000, -400);
                         CurrentState = Reverse_Wall;
                     } 
                     else {
-                       RightWheelSpeed(-1000);
-                        LeftWheelSpeed(-400);
+                        Drive_SetWheels(-400, -1000);
                         LastState = Reverse_Wall;
                         CurrentState = Align_R; 
                     }
@@ -716,22 +724,19 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
         case Reverse_Wall:
             
             if ((ThisEvent.EventType == FRONT_TAPE_UNTRIPPED) && (One_Point_Done)  && (!Two_Point_Done)){
-                RightWheelSpeed(0);
-                LeftWheelSpeed(0);
+                Drive_SetWheels(0, 0);
                 CurrentState = Shoot_2PT;
                 ES_Timer_InitTimer(MOVE_FWD_TIMER, MOVE_FWD_TICKS);
             }
             if ((ThisEvent.EventType == BACK_LEFT_WALL_FAR) && Side == LEFT){
                 LastState = CurrentState;
                 CurrentState = Align_R;
-                RightWheelSpeed(-1000);
-                LeftWheelSpeed(-400);
+                Drive_SetWheels(-400, -1000);
             }
             else if ((ThisEvent.EventType == BACK_RIGHT_WALL_FAR) && Side == RIGHT){
                 LastState = CurrentState;
                 CurrentState = Align_R;
-                RightWheelSpeed(-400);
-                LeftWheelSpeed(-1000);
+                Drive_SetWheels(-1000, -400);
             }  
 
 //            if ((ThisEvent.EventType == ON_WIRE) && (!Collision_Flag)){
@@ -746,23 +751,19 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     if (Two_Point_Done){
                         CurrentState = BAlign_RETURN;
                          if (Side == LEFT) {
-                            RightWheelSpeed(-300);
-                            LeftWheelSpeed(300);
+                            Drive_SetWheels(300, -300);
                         }
                         else {
-                            RightWheelSpeed(300);
-                            LeftWheelSpeed(-300);    
+                            Drive_SetWheels(-300, 300);
                         }
                     } else {
                         CurrentState = BAlign_LEAVE;
 
                         if (Side == LEFT) {
-                            RightWheelSpeed(-400);
-                            LeftWheelSpeed(300);
+                            Drive_SetWheels(300, -400);
                         }
                         else {
-                            RightWheelSpeed(300);
-                            LeftWheelSpeed(-400);    
+                            Drive_SetWheels(-400, 300);
                         }
                         Side = !Side;
                     }
@@ -780,19 +781,16 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
         case Align_R:
             
             if ((ThisEvent.EventType == FRONT_TAPE_UNTRIPPED) && (One_Point_Done) && (!Two_Point_Done)){
-                RightWheelSpeed(0);
-                LeftWheelSpeed(0);
+                Drive_SetWheels(0, 0);
                 CurrentState = Shoot_2PT;
                 ES_Timer_InitTimer(MOVE_FWD_TIMER, MOVE_FWD_TICKS);
             }
             if ((ThisEvent.EventType == BACK_LEFT_WALL_INRANGE) && (Side == LEFT)){
-                RightWheelSpeed(-400);
-                LeftWheelSpeed(-1000);
+                Drive_SetWheels(-1000, -400);
                 CurrentState = LastState;
             }
             if ((ThisEvent.EventType == BACK_RIGHT_WALL_INRANGE) && (Side == RIGHT)){
-                RightWheelSpeed(-1000);
-                LeftWheelSpeed(-400);
+                Drive_SetWheels(-400, -1000);
                 CurrentState = LastState;
             } 
 
@@ -807,23 +805,19 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     if (Two_Point_Done){
                         CurrentState = BAlign_RETURN;
                          if (Side == LEFT) {
-                            RightWheelSpeed(-300);
-                            LeftWheelSpeed(300);
+                            Drive_SetWheels(300, -300);
                         }
                         else {
-                            RightWheelSpeed(300);
-                            LeftWheelSpeed(-300);    
+                            Drive_SetWheels(-300, 300);
                         }
                     } else {
                         CurrentState = BAlign_LEAVE;
 
                         if (Side == LEFT) {
-                            RightWheelSpeed(-300);
-                            LeftWheelSpeed(300);
+                            Drive_SetWheels(300, -300);
                         }
                         else {
-                            RightWheelSpeed(300);
-                            LeftWheelSpeed(-300);    
+                            Drive_SetWheels(-300, 300);
                         }
                         Side = !Side;
                     }
@@ -843,8 +837,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     CurrentState = Follow_Wall;
                     RightWheelSpeed(1000);
                     //LeftWheelSpeed(400);  
-                    LeftFlyWheelSpeed(0);
-                    RightFlyWheelSpeed(0);
+                    Flywheel_SetSpeed(0);
                     ES_Timer_InitTimer(BACK_WALL_FOLLOW_TIMER, BW_TICKS);
                 }
             }
@@ -854,8 +847,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     CurrentState = Follow_Wall;
                     //RightWheelSpeed(400);
                     LeftWheelSpeed(1000);
-                    LeftFlyWheelSpeed(0);
-                    RightFlyWheelSpeed(0);
+                    Flywheel_SetSpeed(0);
                     ES_Timer_InitTimer(BACK_WALL_FOLLOW_TIMER, BW_TICKS);
                 }
             }
@@ -875,23 +867,19 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 ES_Timer_InitTimer(TAPE_BLOCK_TIMER, TAPE_BLOCK_TICKS);
                 
                 if (Side == RIGHT){
-                    if (Analog_TapeRead_R() < 450){
-                        RightWheelSpeed(-1000);
-                        LeftWheelSpeed(-400); 
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
+                        Drive_SetWheels(-400, -1000);
                         CurrentState = Reverse_Wall;
                     } else {
-                       RightWheelSpeed(-400);
-                        LeftWheelSpeed(-1000); 
+                        Drive_SetWheels(-1000, -400);
                         CurrentState = Align_R; 
                     }
                 } else if (Side == LEFT){
-                    if (Analog_TapeRead_L() < 450){
-                        RightWheelSpeed(-400);
-                        LeftWheelSpeed(-1000); 
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
+                        Drive_SetWheels(-1000, -400);
                         CurrentState = Reverse_Wall;
                     } else {
-                       RightWheelSpeed(-1000);
-                        LeftWheelSpeed(-400); 
+                        Drive_SetWheels(-400, -1000);
                         CurrentState = Align_R; 
                     }
                 }   
@@ -935,8 +923,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 if (ThisEvent.EventType == FRONT_LEFT_WALL_INRANGE){
                     CurrentState = Follow_Wall;
                     Side = !Side;
-                    RightWheelSpeed(400);
-                    LeftWheelSpeed(1000);
+                    Drive_SetWheels(1000, 400);
                     TapeFlag = FALSE;
                     //LeftFlyWheelSpeed(-300);
                     ES_Timer_InitTimer(RETURN_TIMER, BW_TICKS);
@@ -946,8 +933,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 if (ThisEvent.EventType == FRONT_RIGHT_WALL_INRANGE){
                     CurrentState = Follow_Wall;
                     Side = !Side;
-                    RightWheelSpeed(1000);
-                    LeftWheelSpeed(400);
+                    Drive_SetWheels(400, 1000);
                     TapeFlag = FALSE;
                     //RightFlyWheelSpeed(-300);
                     ES_Timer_InitTimer(RETURN_TIMER, BW_TICKS);
@@ -956,10 +942,8 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             
             break;
         case Reload:
-            RightWheelSpeed(0);
-            LeftWheelSpeed(0);
-            LeftFlyWheelSpeed(-300);
-            RightFlyWheelSpeed(-300);
+            Drive_SetWheels(0, 0);
+            Flywheel_SetSpeed(Params_Get(PARAM_FLYWHEEL_SPEED));
                 
 
             if (ThisEvent.EventType == ES_TIMEOUT){
@@ -974,24 +958,20 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             
             if (!Collision_Flag){        
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_FR() < 450){
-                            RightWheelSpeed(1000);
-                            LeftWheelSpeed(400);
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_FR, TAPE_CLOSE)){
+                            Drive_SetWheels(400, 1000);
                             CurrentState = Follow_Wall;
                         } else {
-                            RightWheelSpeed(400);
-                            LeftWheelSpeed(1000);
+                            Drive_SetWheels(1000, 400);
                             LastState = Follow_Wall;
                             CurrentState = Align_F;
                         }
                     } else if (Side == LEFT){
-                        if (Analog_TapeRead_FL() < 450){
-                            RightWheelSpeed(400);
-                            LeftWheelSpeed(1000);
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_FL, TAPE_CLOSE)){
+                            Drive_SetWheels(1000, 400);
                             CurrentState = Follow_Wall;
                         } else {
-                            RightWheelSpeed(1000);
-                            LeftWheelSpeed(400);
+                            Drive_SetWheels(400, 1000);
                             LastState = Follow_Wall;
                             CurrentState = Align_F;
                         }
@@ -1001,12 +981,10 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             else if (Collision_Flag) {
                 CurrentState = BAlign_LEAVE;
                 if (Side == RIGHT) {
-                    RightWheelSpeed(400);
-                    LeftWheelSpeed(-400);
+                    Drive_SetWheels(-400, 400);
                 }
                 else if (Side == LEFT){
-                    RightWheelSpeed(-400);
-                    LeftWheelSpeed(600);
+                    Drive_SetWheels(600, -400);
                 }
             }
                 }
@@ -1015,16 +993,59 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             break;
             
         case Test_Stop:
-           LeftFlyWheelSpeed(0);
-           RightFlyWheelSpeed(0);
-           RightWheelSpeed(0);
-           LeftWheelSpeed(0);
+           Flywheel_SetSpeed(0);
+           Drive_SetWheels(0, 0);
            break;
             
+        case Tune:
+            //the bumper held at power up is still down, start on the first press after
+            //it has been let go
+            if (ThisEvent.EventType == BUMPER_BUMPED) {
+                if (ThisEvent.EventParam == 0) {
+                    Tuning = FALSE;
+                } else if (!Tuning) {
+                    printf("tuning done\r\n");
+                    CurrentState = Find_Beacon;
+                }
+            }
+            break;
+            
         default: // all unhandled states fall into here
             break;
     } // end switch on Current State
     
+    // a critical battery, or no working wall sensor on either side, stops the robot,
+    // but only once any shot in progress is done
+    if ((BatteryCritical || (WallBlind[RIGHT] && WallBlind[LEFT])) && (CurrentState != Test_Stop)
+            && (CurrentState != Shoot_1PT) && (CurrentState != Shoot_2PT) && (CurrentState != Shoot_3PT)) {
+        CurrentState = Test_Stop;
+        Flywheel_SetSpeed(0);
+        Drive_SetWheels(0, 0);
+    }
+    
+    // the wall controller owns the wheels for as long as we are in Follow_Wall, every
+    // way out of it has already set the wheel speeds it wants above. With that wall
+    // blind it would only seek into it, so drive straight on and leave the tape, the
+    // bumpers and the timers to end the run.
+    if ((CurrentState == Follow_Wall) && !WallBlind[Side]) {
+        if (!WallController_IsEnabled()) {
+            WallController_Enable(Side);
+        }
+    } else {
+        if (WallController_IsEnabled()) {
+            WallController_Disable();
+        }
+        if (CurrentState == Follow_Wall) {
+            Drive_SetWheels(Params_Get(PARAM_WALL_SPEED), Params_Get(PARAM_WALL_SPEED));
+        }
+    }
+    
+    // a sweep belongs to Find_Beacon, one left running after any other way out of it
+    // would post a stale BEACON_BEARING into whatever state comes next
+    if ((CurrentState != Find_Beacon) && Beacon_IsSweeping()) {
+        Beacon_StopSweep();
+    }
+    
     return ThisEvent;
 }
 
@@ -57,6 +57,10 @@
  #define BIT_1                        (1 << 1)
  #define BIT_0                        (1 << 0)
 
+// the core timer read with _CP0_GET_COUNT() counts at half of the 80MHz system clock
+#define CORE_TICKS_PER_MS 40000
+#define CORE_TICKS_PER_US 40
+
 /*****************************************************************************/
 // Boolean defines for TRUE, FALSE, SUCCESS and ERROR
 #ifndef FALSE
@@ -0,0 +1,160 @@
+/*
+ * File: Battery.c
+ *
+ * The battery reading and the motor load are filtered with the same first order
+ * filter in Q8. The sag correction then lines up with the voltage it is correcting,
+ * even though the load changes in one step and the voltage follows it through the
+ * filter. The correction is linear in the load, with PARAM_BATTERY_SAG counts per
+ * 1000 PWM. To tune it, compare Battery_GetVoltage at rest and with the flywheels
+ * running.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Battery.h"
+#include "BdayFSM.h"
+#include "AD.h"
+#include "Motor_Driver.h"
+#include "Params.h"
+#include <stdio.h>
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define BATTERY_FILTER_SHIFT 3          //1/8 weight per update, about 80 ms
+#define BATTERY_FRACTION 8              //filtered values are kept in Q8
+
+#define BATTERY_LOW_THRESHOLD 275       //A/D counts, corrected for load
+#define BATTERY_CRITICAL_THRESHOLD 263  //the old lockout level
+#define BATTERY_HYSTERESIS 4            //counts above a threshold to recover from it
+#define BATTERY_PERSIST 100             //updates a new level has to hold, 1 s
+#define BATTERY_NO_BATTERY 169          //running from USB, nothing to grade
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static uint8_t MyPriority;
+static int32_t VoltageQ8;
+static int32_t LoadQ8;
+static unsigned char Level = BATTERY_LEVEL_OK;
+static unsigned char Persist = 0;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t InitBattery(uint8_t Priority)
+{
+    ES_Event ThisEvent;
+
+    MyPriority = Priority;
+    ThisEvent.EventType = ES_INIT;
+    if (ES_PostToService(MyPriority, ThisEvent) == TRUE) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+uint8_t PostBattery(ES_Event ThisEvent)
+{
+    return ES_PostToService(MyPriority, ThisEvent);
+}
+
+ES_Event RunBattery(ES_Event ThisEvent)
+{
+    ES_Event ReturnEvent;
+    ES_Event LevelEvent;
+    uint16_t Reading;
+    uint16_t Estimate;
+    unsigned char NewLevel;
+
+    ReturnEvent.EventType = ES_NO_EVENT;
+
+    switch (ThisEvent.EventType) {
+    case ES_INIT:
+        VoltageQ8 = (int32_t) AD_ReadADPin(BAT_VOLTAGE) << BATTERY_FRACTION;
+        LoadQ8 = (int32_t) Motors_GetLoad() << BATTERY_FRACTION;
+        ES_Timer_InitTimer(BATTERY_TIMER, BATTERY_TICKS);
+        break;
+
+    case ES_TIMEOUT:
+        if (ThisEvent.EventParam != BATTERY_TIMER) {
+            break;
+        }
+        ES_Timer_InitTimer(BATTERY_TIMER, BATTERY_TICKS);
+        Reading = AD_ReadADPin(BAT_VOLTAGE);
+        VoltageQ8 += (((int32_t) Reading << BATTERY_FRACTION) - VoltageQ8) >> BATTERY_FILTER_SHIFT;
+        LoadQ8 += (((int32_t) Motors_GetLoad() << BATTERY_FRACTION) - LoadQ8) >> BATTERY_FILTER_SHIFT;
+        if (Reading <= BATTERY_NO_BATTERY) {
+            Persist = 0;
+            break;
+        }
+
+        Estimate = Battery_GetEstimate();
+        if (Estimate <= BATTERY_CRITICAL_THRESHOLD) {
+            NewLevel = BATTERY_LEVEL_CRITICAL;
+        } else if (Estimate <= BATTERY_LOW_THRESHOLD) {
+            NewLevel = BATTERY_LEVEL_LOW;
+        } else {
+            NewLevel = BATTERY_LEVEL_OK;
+        }
+        //only recover once clear of the threshold, so noise on it cannot toggle the level
+        if (NewLevel < Level) {
+            if ((Level == BATTERY_LEVEL_CRITICAL) && (Estimate <= BATTERY_CRITICAL_THRESHOLD + BATTERY_HYSTERESIS)) {
+                NewLevel = Level;
+            } else if ((Level == BATTERY_LEVEL_LOW) && (Estimate <= BATTERY_LOW_THRESHOLD + BATTERY_HYSTERESIS)) {
+                NewLevel = Level;
+            }
+        }
+        if (NewLevel == Level) {
+            Persist = 0;
+            break;
+        }
+        if (++Persist < BATTERY_PERSIST) {
+            break;
+        }
+        Persist = 0;
+        //recovering, for a fresh battery, is not announced
+        if (NewLevel > Level) {
+            LevelEvent.EventType = (NewLevel == BATTERY_LEVEL_CRITICAL) ? BATTERY_CRITICAL : BATTERY_LOW;
+            LevelEvent.EventParam = Estimate;
+            PostBdayFSM(LevelEvent);
+        }
+        Level = NewLevel;
+        break;
+
+    default:
+        break;
+    }
+    return ReturnEvent;
+}
+
+uint16_t Battery_GetVoltage(void)
+{
+    return VoltageQ8 >> BATTERY_FRACTION;
+}
+
+uint16_t Battery_GetEstimate(void)
+{
+    return (VoltageQ8 >> BATTERY_FRACTION) + (Params_Get(PARAM_BATTERY_SAG) * (LoadQ8 >> BATTERY_FRACTION)) / 1000;
+}
+
+uint16_t Battery_PredictLoaded(unsigned int Load)
+{
+    int32_t Loaded = (int32_t) Battery_GetEstimate() - ((int32_t) Params_Get(PARAM_BATTERY_SAG) * Load) / 1000;
+
+    return (Loaded > 0) ? Loaded : 0;
+}
+
+unsigned char Battery_GetLevel(void)
+{
+    return Level;
+}
@@ -0,0 +1,61 @@
+/*
+ * File: Battery.h
+ *
+ * Battery monitor service, replacing the undervoltage lockout that used to run in
+ * the A/D interrupt. Every BATTERY_TICKS ms it filters the battery reading and corrects
+ * it for the sag caused by the commanded motor load. When the corrected voltage stays
+ * low it posts BATTERY_LOW and then BATTERY_CRITICAL to BdayFSM. The parameter of
+ * both events is the corrected voltage in A/D counts.
+ */
+
+#ifndef Battery_H
+#define Battery_H
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define BATTERY_TIMER 14
+#define BATTERY_TICKS 10
+
+#define BATTERY_LEVEL_OK 0
+#define BATTERY_LEVEL_LOW 1
+#define BATTERY_LEVEL_CRITICAL 2
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+uint8_t InitBattery(uint8_t Priority);
+
+uint8_t PostBattery(ES_Event ThisEvent);
+
+ES_Event RunBattery(ES_Event ThisEvent);
+
+/**
+ * @Function Battery_GetVoltage(void)
+ * @return filtered battery reading in A/D counts, as measured under load */
+uint16_t Battery_GetVoltage(void);
+
+/**
+ * @Function Battery_GetEstimate(void)
+ * @return filtered reading corrected for the motor load, in A/D counts. This is what
+ *         the levels are graded on. */
+uint16_t Battery_GetEstimate(void);
+
+/**
+ * @Function Battery_PredictLoaded(unsigned int Load)
+ * @param Load - total motor load as from Motors_GetLoad, 0 to 4000
+ * @return the reading expected under that load, in A/D counts
+ * @brief Lets a caller check whether spinning up a motor would take the battery below
+ *        a level before it does so */
+uint16_t Battery_PredictLoaded(unsigned int Load);
+
+/**
+ * @Function Battery_GetLevel(void)
+ * @return BATTERY_LEVEL_OK, BATTERY_LEVEL_LOW or BATTERY_LEVEL_CRITICAL */
+unsigned char Battery_GetLevel(void);
+
+#endif /* Battery_H */
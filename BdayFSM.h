@@ -24,6 +24,7 @@
  ******************************************************************************/
 
 #include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+#include "Params.h"
 
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
@@ -33,13 +34,13 @@
 #define RIGHT 0 
 
 #define BALL_RELEASE_TIMER 3
-#define BALL_RELEASE_TICKS 400
+#define BALL_RELEASE_TICKS Params_Get(PARAM_BALL_RELEASE_TICKS)
 
 #define MOVE_FWD_TIMER 1
 #define MOVE_FWD_TICKS 500
 
 #define SHOOT_TIMER 9
-#define SHOOT_TICKS 1000
+#define SHOOT_TICKS Params_Get(PARAM_SHOOT_TICKS)
 
 extern unsigned char Side;
 /*******************************************************************************
@@ -1,3 +1,11 @@
+//#define BEACON_TEST
+//#define BEACON_CARRIER      //needs W8 rewired to the raw 2kHz carrier, see below
+
+#ifdef BEACON_TEST
+#define BEACON_CARRIER      //the harness exercises the Goertzel
+#endif
+
+#ifndef BEACON_TEST
 #include "ES_Configure.h"
 #include "BCEventChecker.h"
 #include "BumperSensor.h"
@@ -12,18 +20,491 @@
 #include "Beacon.h"
 
 #include <xc.h>
+#else
+#include <stdint.h>
+#define TRUE 1
+#define FALSE 0
+#define SUCCESS 1
+#define ERROR 0
+#define BEACON_FREQUENCY 2000   //as in Beacon.h
+#define MIN_PWM_FREQ 100        //as in pwm.h
+#define AD_PORTW8 0
+static unsigned char AD_Init(void);
+static char AD_AddScanHook(void (*Hook)(void));
+static char AD_AddPins(unsigned int Pins);
+static char AD_SetSampleRate(unsigned int SamplesPerSecond);
+static unsigned int AD_GetScanRate(void);
+static unsigned int AD_ReadADPin(unsigned int Pin);
+static uint32_t ES_Timer_GetTime(void);
+#endif
 #include <stdio.h>
+#include <math.h>
 
 #define BEACON AD_PORTW8
 
+/*
+ * With BEACON_CARRIER the beacon channel is demodulated with a Goertzel filter fed from
+ * every A/D scan. Beacon_Init asks the A/D for BEACON_SAMPLE_RATE, 5x the carrier:
+ * above Nyquist, and the 3rd, 5th and 7th harmonics of the square wave fold to 2f and
+ * DC rather than onto the tone. The coefficient is computed from the scan rate the A/D
+ * really achieved, and recomputed whenever the pin set (and so the rate) changes.
+ *
+ * The detector board as built puts an already demodulated level on AD_PORTW8 (low with
+ * the beacon in view, which is what the old 250/1000 thresholds read), and a tone filter
+ * never finds a 2kHz tone in that. So the robot builds without BEACON_CARRIER: the block
+ * mean of that level is thresholded at the old 250/1000, the sweep and hysteresis work
+ * on it, and ambient light or motor noise is NOT rejected. The Goertzel path is only
+ * built and checked by BEACON_TEST until W8 is wired to the carrier ahead of the
+ * envelope detector, then define BEACON_CARRIER and set the thresholds on the robot.
+ */
+#define BLOCK_SHIFT 5
+#define BLOCK_SIZE (1 << BLOCK_SHIFT)   //samples per Goertzel block
+#define COEFF_SHIFT 14                  //Goertzel coefficient is Q14
+#define TWO_PI 6.28318531f
+#define BEACON_SAMPLE_RATE (5 * BEACON_FREQUENCY)
+#define BEACON_FULL_SCALE 1023
+
+#ifdef BEACON_CARRIER
+//hysteresis on the detector output, strength in A/D counts of tone amplitude
+#define PRESENT_STRENGTH 40
+#define ABSENT_STRENGTH 20
+#define PRESENT_CONFIDENCE 20           //percent of the AC energy that is beacon tone
+#define ABSENT_CONFIDENCE 10
+#else
+//strength is full scale less the demodulated level, present below 250 and absent above 1000
+#define PRESENT_STRENGTH (BEACON_FULL_SCALE - 250)
+#define ABSENT_STRENGTH (BEACON_FULL_SCALE - 1000)
+#define PRESENT_CONFIDENCE 0
+#define ABSENT_CONFIDENCE 0
+#endif
+
+//sweep peak finding, a sweep ends once the strength falls below half of its peak
+#define SWEEP_LENGTH 8                  //power of 2, blocks buffered for the main loop
+#define SWEEP_DROP_SHIFT 1
+
+static volatile unsigned int Strength;
+static volatile unsigned char Confidence;
+static volatile unsigned char CoeffStale = TRUE;
+static volatile unsigned int CoeffRate;
+static int Coeff;
+static unsigned char Present = FALSE;
+
+//filter state, only touched from the A/D interrupt
+static int32_t S1;
+static int32_t S2;
+static int32_t BlockSum;
+static int32_t BlockMean;
+static uint32_t BlockEnergy;
+static unsigned char BlockCount;
+
+//block results with their end time, written by the interrupt and read by the sweep
+static volatile uint32_t SweepTime[SWEEP_LENGTH];
+static volatile unsigned int SweepStrength[SWEEP_LENGTH];
+static volatile unsigned char SweepHead;
+static unsigned char SweepTail;
+
+static unsigned char Sweeping = FALSE;
+static unsigned char SweepPoints;
+static uint32_t PeakTime[3];            //blocks before, at, and after the maximum
+static unsigned int PeakStrength[3];
+static unsigned char PeakRight;
+static unsigned int LastStrength;
+static uint32_t LastTime;
+
+static void Beacon_ScanHook(void);
+static void Beacon_Sample(int Sample);
+static void Beacon_EndBlock(void);
+static void Beacon_SetRate(unsigned int Rate);
+static uint32_t Beacon_Sqrt(uint64_t Value);
+static uint32_t Beacon_FitPeak(void);
+
 unsigned char Beacon_Init(void){
     AD_Init();
-    return AD_AddPins(BEACON);
-    
+    AD_AddScanHook(Beacon_ScanHook);
+    if (AD_AddPins(BEACON) == ERROR) {
+        return ERROR;
+    }
+#ifdef BEACON_CARRIER
+    //the coefficient follows AD_GetScanRate, the rate actually achieved
+    return AD_SetSampleRate(BEACON_SAMPLE_RATE);
+#else
+    return SUCCESS;
+#endif
 }
 
 unsigned int ReadBeacon(void){
     //printf("Beacon Reading: %d \r\n", AD_ReadADPin(BEACON));
-    return AD_ReadADPin(BEACON);    
-    
+    return AD_ReadADPin(BEACON);
+
+}
+
+unsigned int Beacon_GetStrength(void){
+    return Strength;
+}
+
+unsigned char Beacon_GetConfidence(void){
+    return Confidence;
+}
+
+unsigned char Beacon_IsPresent(void){
+    unsigned int CurStrength;
+    unsigned char CurConfidence;
+
+    //coefficient math stays out of the interrupt
+    if (CoeffStale) {
+        Beacon_SetRate(AD_GetScanRate());
+    }
+    CurStrength = Strength;
+    CurConfidence = Confidence;
+    if (Present) {
+        if ((CurStrength < ABSENT_STRENGTH) || (CurConfidence < ABSENT_CONFIDENCE)) {
+            Present = FALSE;
+        }
+    } else {
+        if ((CurStrength >= PRESENT_STRENGTH) && (CurConfidence >= PRESENT_CONFIDENCE)) {
+            Present = TRUE;
+        }
+    }
+    return Present;
+}
+
+void Beacon_StartSweep(void){
+    SweepTail = SweepHead;
+    SweepPoints = 0;
+    PeakStrength[1] = 0;
+    PeakRight = FALSE;
+    LastStrength = 0;
+    Sweeping = TRUE;
+}
+
+void Beacon_StopSweep(void){
+    Sweeping = FALSE;
+}
+
+unsigned char Beacon_IsSweeping(void){
+    return Sweeping;
+}
+
+unsigned char Beacon_SweepPeak(uint32_t *Peak){
+    unsigned int CurStrength;
+    uint32_t CurTime;
+
+    while (SweepTail != SweepHead) {
+        CurStrength = SweepStrength[SweepTail];
+        CurTime = SweepTime[SweepTail];
+        SweepTail = (SweepTail + 1) & (SWEEP_LENGTH - 1);
+        if (!Sweeping) {
+            continue;
+        }
+        if (SweepPoints < 255) {
+            SweepPoints++;
+        }
+        if (PeakRight) {
+            //the block after a new maximum is its right neighbour
+            PeakStrength[2] = CurStrength;
+            PeakTime[2] = CurTime;
+            PeakRight = FALSE;
+        }
+        if (CurStrength > PeakStrength[1]) {
+            PeakStrength[0] = (SweepPoints > 1) ? LastStrength : CurStrength;
+            PeakTime[0] = (SweepPoints > 1) ? LastTime : CurTime;
+            PeakStrength[1] = CurStrength;
+            PeakTime[1] = CurTime;
+            PeakRight = TRUE;
+        } else if ((PeakStrength[1] >= PRESENT_STRENGTH) && !PeakRight &&
+                (CurStrength < (PeakStrength[1] >> SWEEP_DROP_SHIFT))) {
+            //we have rotated past the beacon
+            Sweeping = FALSE;
+            *Peak = Beacon_FitPeak();
+            return TRUE;
+        }
+        LastStrength = CurStrength;
+        LastTime = CurTime;
+    }
+    return FALSE;
+}
+
+/**
+ * @function Beacon_ScanHook(void)
+ * @brief Called from the A/D interrupt after each scan, feeds the beacon sample to the
+ *        filter. Blocks are dropped while the coefficient does not match the scan rate.
+ */
+static void Beacon_ScanHook(void){
+    if (BlockCount == 0) {
+        if (CoeffStale) {
+            return;
+        }
+        if (AD_GetScanRate() != CoeffRate) {
+            CoeffStale = TRUE;
+            Strength = 0;
+            Confidence = 0;
+            return;
+        }
+    }
+    Beacon_Sample(AD_ReadADPin(BEACON));
+}
+
+static void Beacon_Sample(int Sample){
+#ifdef BEACON_CARRIER
+    int32_t x;
+    int32_t s0;
+
+    //remove the DC level with the mean of the previous block
+    x = Sample - BlockMean;
+    s0 = x + (int32_t) (((int64_t) Coeff * S1) >> COEFF_SHIFT) - S2;
+    S2 = S1;
+    S1 = s0;
+    BlockEnergy += x * x;
+#endif
+    BlockSum += Sample;
+    BlockCount++;
+    if (BlockCount >= BLOCK_SIZE) {
+        Beacon_EndBlock();
+    }
+}
+
+static void Beacon_EndBlock(void){
+#ifdef BEACON_CARRIER
+    int64_t Power;
+    int64_t Ratio;
+
+    Power = (int64_t) S1 * S1 + (int64_t) S2 * S2 - ((((int64_t) S1 * S2) * Coeff) >> COEFF_SHIFT);
+    if (Power < 0) {
+        Power = 0;
+    }
+    //a tone of amplitude A gives Power = (A * N / 2)^2 and Energy = N * A^2 / 2
+    Strength = (Beacon_Sqrt(Power) * 2) >> BLOCK_SHIFT;
+    if (BlockEnergy == 0) {
+        Confidence = 0;
+    } else {
+        Ratio = (Power * 200) / ((int64_t) BlockEnergy << BLOCK_SHIFT);
+        Confidence = (Ratio > 100) ? 100 : Ratio;
+    }
+#else
+    //the level drops as the beacon comes into view
+    Strength = BEACON_FULL_SCALE - (BlockSum >> BLOCK_SHIFT);
+    Confidence = 100;
+#endif
+    SweepTime[SweepHead] = ES_Timer_GetTime();
+    SweepStrength[SweepHead] = Strength;
+    SweepHead = (SweepHead + 1) & (SWEEP_LENGTH - 1);
+    BlockMean = BlockSum >> BLOCK_SHIFT;
+    BlockSum = 0;
+    BlockEnergy = 0;
+    BlockCount = 0;
+    S1 = 0;
+    S2 = 0;
+}
+
+static void Beacon_SetRate(unsigned int Rate){
+    if (Rate == 0) {
+        return;
+    }
+    Coeff = (int) (2.0f * cosf(TWO_PI * BEACON_FREQUENCY / Rate) * (1 << COEFF_SHIFT));
+    CoeffRate = Rate;
+    CoeffStale = FALSE;
+}
+
+/**
+ * @function Beacon_FitPeak(void)
+ * @return time in ms at which the beacon was dead ahead
+ * @brief Fits a parabola through the largest block and its two neighbours, the vertex
+ *        is the peak. Block times are the end of each block so half a block is taken off.
+ */
+static uint32_t Beacon_FitPeak(void){
+    int32_t Left = PeakStrength[0];
+    int32_t Mid = PeakStrength[1];
+    int32_t Right = PeakStrength[2];
+    int32_t Spacing = (int32_t) (PeakTime[2] - PeakTime[0]) / 2;
+    int32_t Curve = Left - 2 * Mid + Right;
+    int32_t Offset = 0;
+
+    if (Curve < 0) {
+        Offset = (Spacing * (Left - Right)) / (2 * Curve);
+        if (Offset > Spacing / 2) Offset = Spacing / 2;
+        if (Offset < -Spacing / 2) Offset = -Spacing / 2;
+    }
+    return PeakTime[1] + Offset - ((BLOCK_SIZE * 500) / CoeffRate);
+}
+
+static uint32_t Beacon_Sqrt(uint64_t Value){
+    uint64_t Root = 0;
+    uint64_t Bit = (uint64_t) 1 << 62;
+
+    while (Bit > Value) {
+        Bit >>= 2;
+    }
+    while (Bit != 0) {
+        if (Value >= Root + Bit) {
+            Value -= Root + Bit;
+            Root = (Root >> 1) + Bit;
+        } else {
+            Root >>= 1;
+        }
+        Bit >>= 2;
+    }
+    return Root;
+}
+
+#ifdef BEACON_TEST
+/*
+ * Feeds synthetic beacon detector traces through the same filter and hysteresis the
+ * A/D hook uses, without the A/D running. Reports how long a beacon takes to be
+ * declared and how often noise alone is declared a beacon. Built on a PC with
+ *     gcc -DBEACON_TEST Beacon.c -o beacontest -lm
+ */
+#define TEST_RATE 10162         //what BEACON_SAMPLE_RATE comes out as with the 6 robot pins
+#define TEST_SECONDS 60
+#define TEST_TRIALS 20
+
+static unsigned char AD_Init(void)
+{
+    return SUCCESS;
+}
+
+static char AD_AddScanHook(void (*Hook)(void))
+{
+    (void) Hook;
+    return SUCCESS;
+}
+
+static char AD_AddPins(unsigned int Pins)
+{
+    (void) Pins;
+    return SUCCESS;
+}
+
+static char AD_SetSampleRate(unsigned int SamplesPerSecond)
+{
+    (void) SamplesPerSecond;
+    return SUCCESS;
+}
+
+static unsigned int AD_GetScanRate(void)
+{
+    return TEST_RATE;
+}
+
+static unsigned int AD_ReadADPin(unsigned int Pin)
+{
+    (void) Pin;
+    return 0;
+}
+
+static uint32_t ES_Timer_GetTime(void)
+{
+    return 0;
+}
+
+static uint32_t Seed = 12345;
+
+static int Noise(int Amplitude){
+    Seed = Seed * 1103515245 + 12345;
+    if (Amplitude == 0) {
+        return 0;
+    }
+    return (int) ((Seed >> 16) % (2 * Amplitude + 1)) - Amplitude;
+}
+
+static void ResetDetector(void){
+    S1 = 0;
+    S2 = 0;
+    BlockSum = 0;
+    BlockMean = 0;
+    BlockEnergy = 0;
+    BlockCount = 0;
+    Strength = 0;
+    Confidence = 0;
+    Present = FALSE;
+}
+
+/*
+ * One sample of the detector output: a square wave at the beacon frequency when it is
+ * in view, plus white noise and a square wave at the motor PWM frequency.
+ */
+static int TraceSample(uint32_t n, int Beacon, int NoiseAmp, int MotorAmp){
+    int Sample = 600;
+    uint32_t Phase;
+
+    Phase = ((uint64_t) n * BEACON_FREQUENCY * 65536 / TEST_RATE) & 0xFFFF;
+    if (Beacon) {
+        Sample += (Phase < 0x8000) ? -Beacon : Beacon;
+    }
+    Phase = ((uint64_t) n * MIN_PWM_FREQ * 65536 / TEST_RATE) & 0xFFFF;
+    Sample += (Phase < 0x8000) ? -MotorAmp : MotorAmp;
+    Sample += Noise(NoiseAmp);
+    if (Sample < 0) Sample = 0;
+    if (Sample > 1023) Sample = 1023;
+    return Sample;
+}
+
+int main(void){
+    static const int Beacons[] = {300, 100, 50};
+    static const int NoiseLevels[] = {20, 100, 200};
+    uint32_t n;
+    uint32_t Latency;
+    uint32_t WorstLatency;
+    uint32_t TotalLatency;
+    uint32_t Missed;
+    uint32_t Alarms;
+    uint32_t Blocks;
+    unsigned char Was;
+    int b, k, t;
+
+    printf("\r\nBeacon Goertzel detector test harness, %d Hz beacon, %d Hz scan, %d sample blocks\r\n",
+            BEACON_FREQUENCY, TEST_RATE, BLOCK_SIZE);
+    Beacon_Init();
+    Beacon_IsPresent();
+
+    for (k = 0; k < 3; k++) {
+        for (b = 0; b < 3; b++) {
+            TotalLatency = 0;
+            WorstLatency = 0;
+            Missed = 0;
+            for (t = 0; t < TEST_TRIALS; t++) {
+                ResetDetector();
+                //settle on noise, then bring the beacon into view at a random phase
+                for (n = 0; n < TEST_RATE / 2; n++) {
+                    Beacon_Sample(TraceSample(n, 0, NoiseLevels[k], 150));
+                    if (BlockCount == 0) Beacon_IsPresent();
+                }
+                n += Noise(TEST_RATE / 2) + TEST_RATE / 2;
+                for (Latency = 0; Latency < TEST_RATE; Latency++) {
+                    Beacon_Sample(TraceSample(n + Latency, Beacons[b], NoiseLevels[k], 150));
+                    if ((BlockCount == 0) && Beacon_IsPresent()) break;
+                }
+                if (Latency >= TEST_RATE) {
+                    Missed++;
+                } else {
+                    TotalLatency += Latency;
+                    if (Latency > WorstLatency) WorstLatency = Latency;
+                }
+            }
+            printf("beacon %3d noise %3d: mean latency %4lu ms, worst %4lu ms, missed %lu/%d\r\n",
+                    Beacons[b], NoiseLevels[k],
+                    (unsigned long) ((Missed < TEST_TRIALS) ? (TotalLatency * 1000 / TEST_RATE) / (TEST_TRIALS - Missed) : 0),
+                    (unsigned long) (WorstLatency * 1000 / TEST_RATE), (unsigned long) Missed, TEST_TRIALS);
+        }
+    }
+
+    //no beacon at all, only noise and motor interference
+    for (k = 0; k < 3; k++) {
+        ResetDetector();
+        Alarms = 0;
+        Blocks = 0;
+        Was = FALSE;
+        for (n = 0; n < (uint32_t) TEST_RATE * TEST_SECONDS; n++) {
+            Beacon_Sample(TraceSample(n, 0, NoiseLevels[k], 300));
+            if (BlockCount == 0) {
+                Blocks++;
+                if (Beacon_IsPresent() && !Was) Alarms++;
+                Was = Present;
+            }
+        }
+        printf("noise %3d + motor: %lu false alarms in %d s (%lu blocks)\r\n",
+                NoiseLevels[k], (unsigned long) Alarms, TEST_SECONDS, (unsigned long) Blocks);
+    }
+    printf("Done\r\n");
+    return 0;
 }
+#endif
@@ -23,6 +23,8 @@
 #include <xc.h>
 #include <stdio.h>
 
+#define BEACON_FREQUENCY 2000 //modulation frequency of the beacon in Hz
+
 //Initializes the Pins to be read
 unsigned char Beacon_Init(void);
 
@@ -34,6 +36,61 @@ unsigned char Beacon_Init(void);
  * @author Leo King */
 unsigned int ReadBeacon(void);
 
+/**
+ * @function Beacon_GetStrength(void)
+ * @param None
+ * @return beacon strength in A/D counts over the last block, higher is closer
+ * @brief Full scale less the mean of the detector board's demodulated level. Built
+ *        with BEACON_CARRIER it is instead the Goertzel amplitude of the 2kHz tone,
+ *        see Beacon.c */
+unsigned int Beacon_GetStrength(void);
+
+/**
+ * @function Beacon_GetConfidence(void)
+ * @param None
+ * @return 0 to 100, percentage of the signal energy that is at the beacon frequency
+ * @brief Only meaningful with BEACON_CARRIER, where ambient light and motor noise give
+ *        a low confidence even when they are strong. Always 100 in the robot build */
+unsigned char Beacon_GetConfidence(void);
+
+/**
+ * @function Beacon_IsPresent(void)
+ * @param None
+ * @return TRUE if the beacon is in view, FALSE otherwise
+ * @brief Applies hysteresis on the strength (and the confidence with BEACON_CARRIER),
+ *        call from the event checker */
+unsigned char Beacon_IsPresent(void);
+
+/**
+ * @function Beacon_StartSweep(void)
+ * @param None
+ * @return None
+ * @brief Starts recording beacon strength against time, call when the robot starts
+ *        rotating at a constant rate to look for the beacon */
+void Beacon_StartSweep(void);
+
+/**
+ * @function Beacon_StopSweep(void)
+ * @param None
+ * @return None
+ * @brief Abandons the current sweep without reporting a peak */
+void Beacon_StopSweep(void);
+
+/**
+ * @function Beacon_IsSweeping(void)
+ * @param None
+ * @return TRUE while a sweep is recording
+ * @brief A sweep stops by itself once its peak has been reported */
+unsigned char Beacon_IsSweeping(void);
+
+/**
+ * @function Beacon_SweepPeak(uint32_t *Peak)
+ * @param Peak - set to the ES_Timer_GetTime() time at which the beacon was strongest
+ * @return TRUE once the robot has rotated past the beacon, FALSE otherwise
+ * @brief Consumes the strength samples since the last call, and once the signal has
+ *        fallen to half of its maximum fits a parabola through the peak samples */
+unsigned char Beacon_SweepPeak(uint32_t *Peak);
+
 /* *****************************************************************************
  End of File
  */
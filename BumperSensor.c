@@ -46,9 +46,13 @@
 #define BumperBackLeft 0b0010
 #define BumperBackRight 0b0001
 
+#define BUMPER_DEBOUNCE_US 5000
+
 unsigned char Bumper_Init(void) {
     IO_PortsSetPortInputs(PORTX, (BumperInBackLeft | BumperInBackRight | BumperInFrontLeft | BumperInFrontRight));
-    return SUCCESS;
+    //contact is reported on the first edge, the switch bounce after it is locked out
+    return IO_PortsEnableChangeNotify(PORTX, (BumperInBackLeft | BumperInBackRight | BumperInFrontLeft | BumperInFrontRight),
+            BUMPER_DEBOUNCE_US);
 }
 
 /**
@@ -56,10 +60,11 @@ unsigned char Bumper_Init(void) {
  * @param None
  * @return 1 or 0 for lower 4-bits, FLeft = 0b1000, FRight = 0b0100, BLeft = 0b0010, BRight = 0b0001 
  * @brief Reads Bumpers out as a 8-bit value where each of the lower four bits
- *        represents a bumper
+ *        represents a bumper. Levels are already debounced, as of the last
+ *        IO_PortsTakeSnapshot.
  * @author Leo King */
 uint8_t BumperRead(void) {
-    uint16_t PORTXPINS = IO_PortsReadPort(PORTX);
+    uint16_t PORTXPINS = IO_PortsGetSnapshot()->debounced[PORTX];
     uint8_t Bumper = 0;
     
     if ((PORTXPINS & BumperInFrontLeft)) {
@@ -13,17 +13,20 @@
 #include <xc.h>
 #include <stdio.h>
 
-#define TAPESENSOR_F PORTX03_BIT 
-#define TAPESENSOR_B PORTX04_BIT 
+#define TAPE_DEBOUNCE_US 500
 
 unsigned char Digital_TapeInit(void){
     
-    return IO_PortsSetPortInputs(PORTX , PIN3 | PIN4);
+    if (IO_PortsSetPortInputs(PORTX , TAPESENSOR_F | TAPESENSOR_B) == ERROR){
+        return ERROR;
+    }
+    return IO_PortsEnableChangeNotify(PORTX, TAPESENSOR_F | TAPESENSOR_B, TAPE_DEBOUNCE_US);
     
 }
 
 unsigned char Read_DigitalTape(void){
+    uint16_t Tape = IO_PortsGetSnapshot()->debounced[PORTX];
     
-    return (TAPESENSOR_F << 1) | (TAPESENSOR_B); 
+    return (((Tape & TAPESENSOR_F) != 0) << 1) | ((Tape & TAPESENSOR_B) != 0); 
     
 }
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include "ES_Configure.h"
+#include "IO_Ports.h"
+
+//PORTX pins of the front and back tape sensors
+#define TAPESENSOR_F PIN3
+#define TAPESENSOR_B PIN4
 
 unsigned char Digital_TapeInit(void);
 
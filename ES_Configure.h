@@ -75,10 +75,22 @@ typedef enum {
             
     BEACON_PRESENT,
     BEACON_ABSENT,
+    BEACON_BEARING, //param is ms since the beacon was dead ahead
             
     SHOOTING_1PT_DONE,
     SHOOTING_2PT_DONE,
     SHOOTING_3PT_DONE,
+            
+    WALL_ESTIMATE, //param has bit LEFT/RIGHT set for each side with a valid estimate
+            
+    BATTERY_LOW, //param is the load corrected battery reading
+    BATTERY_CRITICAL,
+            
+    SENSOR_FAULT, //param is the health mask, bit set for each working wall sensor
+            
+    FLYWHEEL_READY, //param is the predicted flywheel speed, per mille
+            
+    TURNSTILE_ARRIVED, //param is the pulse width the turnstile moved to
 	/* User-defined events end here */
     NUMBEROFEVENTS,
 } ES_EventTyp_t;
@@ -113,9 +125,16 @@ static const char *EventNames[] = {
 	"OFF_WIRE",
 	"BEACON_PRESENT",
 	"BEACON_ABSENT",
+	"BEACON_BEARING",
 	"SHOOTING_1PT_DONE",
 	"SHOOTING_2PT_DONE",
 	"SHOOTING_3PT_DONE",
+	"WALL_ESTIMATE",
+	"BATTERY_LOW",
+	"BATTERY_CRITICAL",
+	"SENSOR_FAULT",
+	"FLYWHEEL_READY",
+	"TURNSTILE_ARRIVED",
 	"NUMBEROFEVENTS",
 };
 
@@ -128,7 +147,10 @@ static const char *EventNames[] = {
 
 /****************************************************************************/
 // This is the list of event checking functions
-#define EVENT_CHECK_LIST //CheckTrackWire, CheckBumpers, CheckDigitalTape, CheckAnalogTape, CheckBeacon, CheckSide
+// None run on every pass. The checkers are run from BdayFSM's TAPE_SERVICE_TIMER right
+// after IO_PortsTakeSnapshot, and the bumpers, digital tape, side switch and polled
+// track wire all read that one snapshot of the ports.
+#define EVENT_CHECK_LIST //CheckBumpers, CheckDigitalTape, CheckTrackWire, CheckAnalogTape, CheckBeacon, CheckSide
 
 /****************************************************************************/
 // These are the definitions for the post functions to be executed when the
@@ -148,8 +170,8 @@ static const char *EventNames[] = {
 #define TIMER10_RESP_FUNC PostBdayFSM
 #define TIMER11_RESP_FUNC PostBdayFSM
 #define TIMER12_RESP_FUNC PostBdayFSM
-#define TIMER13_RESP_FUNC TIMER_UNUSED
-#define TIMER14_RESP_FUNC TIMER_UNUSED
+#define TIMER13_RESP_FUNC PostWallEstimator
+#define TIMER14_RESP_FUNC PostBattery
 #define TIMER15_RESP_FUNC PostBdayFSM
 
 
@@ -171,7 +193,7 @@ static const char *EventNames[] = {
 /****************************************************************************/
 // This macro determines that nuber of services that are *actually* used in
 // a particular application. It will vary in value from 1 to MAX_NUM_SERVICES
-#define NUM_SERVICES 2
+#define NUM_SERVICES 5
 
 /****************************************************************************/
 // These are the definitions for Service 0, the lowest priority service
@@ -203,11 +225,11 @@ static const char *EventNames[] = {
 // These are the definitions for Service 2
 #if NUM_SERVICES > 2
 // the header file with the public fuction prototypes
-#define SERV_2_HEADER "TestService.h"
+#define SERV_2_HEADER "WallEstimator.h"
 // the name of the Init function
-#define SERV_2_INIT TestServiceInit
+#define SERV_2_INIT InitWallEstimator
 // the name of the run function
-#define SERV_2_RUN TestServiceRun
+#define SERV_2_RUN RunWallEstimator
 // How big should this services Queue be?
 #define SERV_2_QUEUE_SIZE 3
 #endif
@@ -218,11 +240,11 @@ static const char *EventNames[] = {
 // These are the definitions for Service 3
 #if NUM_SERVICES > 3
 // the header file with the public fuction prototypes
-#define SERV_3_HEADER "TestService.h"
+#define SERV_3_HEADER "WallController.h"
 // the name of the Init function
-#define SERV_3_INIT TestServiceInit
+#define SERV_3_INIT InitWallController
 // the name of the run function
-#define SERV_3_RUN TestServiceRun
+#define SERV_3_RUN RunWallController
 // How big should this services Queue be?
 #define SERV_3_QUEUE_SIZE 3
 #endif
@@ -231,11 +253,11 @@ static const char *EventNames[] = {
 // These are the definitions for Service 4
 #if NUM_SERVICES > 4
 // the header file with the public fuction prototypes
-#define SERV_4_HEADER "TestService.h"
+#define SERV_4_HEADER "Battery.h"
 // the name of the Init function
-#define SERV_4_INIT TestServiceInit
+#define SERV_4_INIT InitBattery
 // the name of the run function
-#define SERV_4_RUN TestServiceRun
+#define SERV_4_RUN RunBattery
 // How big should this services Queue be?
 #define SERV_4_QUEUE_SIZE 3
 #endif
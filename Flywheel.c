@@ -0,0 +1,248 @@
+/*
+ * File: Flywheel.c
+ *
+ * First order model of a DC motor with a flywheel on it. Driven, the speed settles at
+ * duty x battery / nominal battery with the mechanical time constant
+ * FLYWHEEL_SPINUP_TAU, which does not depend on the voltage. With the command at 0 the
+ * H-bridge lets the wheels coast, which only friction slows. To tune the time
+ * constants, time a spin-up from rest by ear (the pitch stops rising) and take a third
+ * of it, and time a coast down to still for three coast time constants.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#ifndef FLYWHEEL_SIM
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "Flywheel.h"
+#include "Battery.h"
+#include "BdayFSM.h"
+#include "Motor_Driver.h"
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include "Flywheel.h"
+#define TRUE 1
+#define FALSE 0
+#define FLYWHEEL_READY 1
+typedef struct {
+    int EventType;
+    uint16_t EventParam;
+} ES_Event;
+static uint32_t ES_Timer_GetTime(void);
+static uint16_t Battery_GetVoltage(void);
+static int LeftFlyWheelSpeed(int PWM);
+static int RightFlyWheelSpeed(int PWM);
+static uint8_t PostBdayFSM(ES_Event ThisEvent);
+#endif
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define FLYWHEEL_SPINUP_TAU 350         //ms, driven, a guess, not timed yet
+#define FLYWHEEL_COAST_TAU 2000         //ms, command at 0, a guess
+#define FLYWHEEL_SHOT_DROP 150          //per mille of the speed lost to a ball, a guess
+#define FLYWHEEL_NOMINAL_BATTERY 290    //A/D counts the free speed is given at
+#define FLYWHEEL_NO_BATTERY 169         //running from USB, use the nominal battery
+#define FLYWHEEL_MAX_MS 50              //longest step, after a stall in the framework
+#define FLYWHEEL_FRACTION 8             //speeds are kept in Q8
+
+/*******************************************************************************
+ * PRIVATE FUNCTION PROTOTYPES                                                 *
+ ******************************************************************************/
+
+static int32_t Flywheel_GetSettled(void);
+static unsigned char Flywheel_IsWithin(int32_t Settled);
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static int Command = 0;
+static int32_t Speed = 0;               //per mille of free speed, Q8
+static unsigned char Ready = FALSE;
+static uint32_t LastTime = 0;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+int Flywheel_SetSpeed(int PWM)
+{
+    if (!LeftFlyWheelSpeed(PWM) || !RightFlyWheelSpeed(PWM)) {
+        return FALSE;
+    }
+    if (PWM != Command) {
+        Command = PWM;
+        Ready = FALSE;
+    }
+    return TRUE;
+}
+
+void Flywheel_Update(void)
+{
+    ES_Event ReadyEvent;
+    uint32_t Now = ES_Timer_GetTime();
+    uint32_t Elapsed = Now - LastTime;
+    int32_t Settled = Flywheel_GetSettled();
+
+    LastTime = Now;
+    if (Elapsed > FLYWHEEL_MAX_MS) {
+        Elapsed = FLYWHEEL_MAX_MS;
+    }
+    Speed += ((Settled - Speed) * (int32_t) Elapsed) / ((Command != 0) ? FLYWHEEL_SPINUP_TAU : FLYWHEEL_COAST_TAU);
+
+    if (!Flywheel_IsWithin(Settled)) {
+        Ready = FALSE;
+    } else if (!Ready) {
+        Ready = TRUE;
+        ReadyEvent.EventType = FLYWHEEL_READY;
+        ReadyEvent.EventParam = (Speed < 0) ? -Speed >> FLYWHEEL_FRACTION : Speed >> FLYWHEEL_FRACTION;
+        PostBdayFSM(ReadyEvent);
+    }
+}
+
+void Flywheel_Shot(void)
+{
+    Speed -= (Speed * FLYWHEEL_SHOT_DROP) / 1000;
+    if (!Flywheel_IsWithin(Flywheel_GetSettled())) {
+        Ready = FALSE;
+    }
+}
+
+unsigned char Flywheel_IsReady(void)
+{
+    return Ready;
+}
+
+unsigned char Flywheel_MayShoot(void)
+{
+    return FLYWHEEL_GATES_SHOTS ? Ready : TRUE;
+}
+
+int Flywheel_GetPredicted(void)
+{
+    return Speed / (1 << FLYWHEEL_FRACTION);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+/**
+ * @Function Flywheel_GetSettled(void)
+ * @return speed the wheels settle at on the current command and battery, Q8 */
+static int32_t Flywheel_GetSettled(void)
+{
+    int32_t Battery = Battery_GetVoltage();
+
+    if (Battery <= FLYWHEEL_NO_BATTERY) {
+        Battery = FLYWHEEL_NOMINAL_BATTERY;
+    }
+    return (((int32_t) Command * Battery) << FLYWHEEL_FRACTION) / FLYWHEEL_NOMINAL_BATTERY;
+}
+
+/**
+ * @Function Flywheel_IsWithin(int32_t Settled)
+ * @param Settled - settled speed, Q8
+ * @return TRUE when the wheels are commanded and the speed is within tolerance of it */
+static unsigned char Flywheel_IsWithin(int32_t Settled)
+{
+    int32_t Error = Settled - Speed;
+    int32_t Band = (Settled * FLYWHEEL_TOLERANCE) / 1000;
+
+    if (Command == 0) {
+        return FALSE;
+    }
+    if (Error < 0) {
+        Error = -Error;
+    }
+    if (Band < 0) {
+        Band = -Band;
+    }
+    return Error <= Band;
+}
+
+#ifdef FLYWHEEL_SIM
+/*
+ * The two shot cycle of OnePointerSubHSM, built on a PC with
+ *     gcc -DFLYWHEEL_SIM Flywheel.c -o flywheelsim
+ * The wheels are started LeadMs before the first shot is due. With fixed waits
+ * the second shot goes PARAM_FSPEED_1PT_TICKS after the first, with the model it
+ * goes on READY once the gate has closed, at BALL_RELEASE_TICKS - 200.
+ */
+#define SIM_TICK_MS 3
+#define SIM_COMMAND -300
+#define SIM_FSPEED_MS 1200
+#define SIM_GATE_MS 200
+
+static uint32_t SimTime;
+static int32_t SimBattery;
+
+static uint32_t ES_Timer_GetTime(void)
+{
+    return SimTime;
+}
+
+static uint16_t Battery_GetVoltage(void)
+{
+    return SimBattery;
+}
+
+static int LeftFlyWheelSpeed(int PWM)
+{
+    (void) PWM;
+    return TRUE;
+}
+
+static int RightFlyWheelSpeed(int PWM)
+{
+    (void) PWM;
+    return TRUE;
+}
+
+static uint8_t PostBdayFSM(ES_Event ThisEvent)
+{
+    (void) ThisEvent;
+    return TRUE;
+}
+
+static void SimRun(int32_t Battery, uint32_t LeadMs)
+{
+    uint32_t First = 0, Second = 0;
+
+    SimBattery = Battery;
+    SimTime = 0;
+    LastTime = 0;
+    Speed = 0;
+    Command = 0;
+    Ready = FALSE;
+    Flywheel_SetSpeed(SIM_COMMAND);
+    while ((Second == 0) && (SimTime < 10000)) {
+        SimTime += SIM_TICK_MS;
+        Flywheel_Update();
+        if ((First == 0) && (SimTime >= LeadMs) && Flywheel_IsReady()) {
+            First = SimTime;
+            Flywheel_Shot();
+        } else if ((First != 0) && (SimTime >= First + SIM_GATE_MS) && Flywheel_IsReady()) {
+            Second = SimTime;
+        }
+    }
+    printf("battery %3ld lead %4lu ms: first %4lu ms, second %4lu ms after it (fixed %d), speed %d\r\n",
+            (long) Battery, (unsigned long) LeadMs, (unsigned long) First, (unsigned long) (Second - First),
+            SIM_FSPEED_MS, Flywheel_GetPredicted());
+}
+
+int main(void)
+{
+    SimRun(FLYWHEEL_NOMINAL_BATTERY, 2000);
+    SimRun(FLYWHEEL_NOMINAL_BATTERY, 100);
+    SimRun(265, 2000);
+    SimRun(150, 2000);
+    return 0;
+}
+#endif /* FLYWHEEL_SIM */
@@ -0,0 +1,70 @@
+/*
+ * File: Flywheel.h
+ *
+ * Spin-up model for the two shooter flywheels. There is no speed sensor on them, so
+ * the speed is predicted from the commanded duty, the battery reading and the time
+ * since the command changed. When the predicted speed comes within FLYWHEEL_TOLERANCE
+ * of where the wheels will settle, FLYWHEEL_READY is posted to BdayFSM. With
+ * FLYWHEEL_GATES_SHOTS the shooting sub-HSMs fire on it instead of after a fixed wait.
+ * Each shot takes speed out of the wheels, and READY is posted again once they have
+ * recovered.
+ */
+
+#ifndef Flywheel_H
+#define Flywheel_H
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define FLYWHEEL_TOLERANCE 50       //per mille of the settled speed
+#define FLYWHEEL_WAIT_TICKS 1500    //longest a shot waits for READY, a spin-up from rest
+
+//FLYWHEEL_SPINUP_TAU and FLYWHEEL_SHOT_DROP are guesses that have not been timed on the
+//robot, so the shots still go on the fixed delays they always had and FLYWHEEL_READY
+//is only advisory. Set to 1 to hold shots for it once both have been measured.
+#define FLYWHEEL_GATES_SHOTS 0
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function Flywheel_SetSpeed(int PWM)
+ * @param PWM - command for both flywheels, -1000 to 1000
+ * @return TRUE or FALSE for success
+ * @brief Use instead of LeftFlyWheelSpeed and RightFlyWheelSpeed, so the model knows
+ *        about the change. Repeating the current command leaves the model alone. */
+int Flywheel_SetSpeed(int PWM);
+
+/**
+ * @Function Flywheel_Update(void)
+ * @return None
+ * @brief Advances the model by the time since the last call and posts FLYWHEEL_READY
+ *        when the wheels come up to speed. Called from the BdayFSM service tick. */
+void Flywheel_Update(void);
+
+/**
+ * @Function Flywheel_Shot(void)
+ * @return None
+ * @brief Takes the speed a ball carries away out of the model, call with Send_Ball */
+void Flywheel_Shot(void);
+
+/**
+ * @Function Flywheel_IsReady(void)
+ * @return TRUE while the wheels are commanded and predicted within tolerance */
+unsigned char Flywheel_IsReady(void);
+
+/**
+ * @Function Flywheel_MayShoot(void)
+ * @return TRUE if a shot that is due may go now, always TRUE unless FLYWHEEL_GATES_SHOTS
+ *         is set, then the same as Flywheel_IsReady */
+unsigned char Flywheel_MayShoot(void);
+
+/**
+ * @Function Flywheel_GetPredicted(void)
+ * @return predicted speed in per mille of the free speed at full duty on a nominal
+ *         battery, negative when reversed as the shooter runs */
+int Flywheel_GetPredicted(void);
+
+#endif /* Flywheel_H */
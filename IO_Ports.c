@@ -7,6 +7,7 @@
  */
 
 #include <xc.h>
+#include <sys/attribs.h>
 
 #include "BOARD.h"
 #include "serial.h"
@@ -34,6 +35,35 @@
 #define PORTVWMASK 0x01F8       //0b0000 0001 1111 1000
 #define PORTXYZMASK 0x1FF8      //0b0001 1111 1111 1000
 
+#define NUMPORTS 5
+#define NO_CN 0xFF              // pin has no change notification input
+#define EDGE_RING_SIZE 16       // must be a power of 2
+#define EDGE_RING_MASK (EDGE_RING_SIZE - 1)
+
+// PIC32 ports behind the IO board pins, index into the PHYS_ register tables
+#define PHYS_B 0
+#define PHYS_D 1
+#define PHYS_E 2
+#define PHYS_F 3
+#define PHYS_G 4
+#define NUMPHYS 5
+
+#define SLICE_BITS 4            // pins of the pattern looked up at once
+#define SLICE_MASK ((1 << SLICE_BITS) - 1)
+#define NUMSLICES 3             // covers bits 3 to 14
+
+// every combination of four physical bits, in the order of a SLICE_BITS wide index
+#define SLICE(b0, b1, b2, b3) { \
+    0, (b0), (b1), (b0) | (b1), (b2), (b0) | (b2), (b1) | (b2), (b0) | (b1) | (b2), \
+    (b3), (b0) | (b3), (b1) | (b3), (b0) | (b1) | (b3), (b2) | (b3), (b0) | (b2) | (b3), \
+    (b1) | (b2) | (b3), (b0) | (b1) | (b2) | (b3)}
+
+// one PIC32 port of an IO port, p3 to p12 are the physical bits of header pins 3 to
+// 12 on that PIC32 port, ZERO for the pins on another one
+#define GROUP(phys, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12) { \
+    (phys), (p3) | (p4) | (p5) | (p6) | (p7) | (p8) | (p9) | (p10) | (p11) | (p12), { \
+    SLICE(p3, p4, p5, p6), SLICE(p7, p8, p9, p10), SLICE(p11, p12, ZERO, ZERO)}}
+
 // code readability macros
 #define IO_PortsSetInput(port,i) *PORTS_TRISSET[port][i-OFFSET] = PortsBits[port][i-OFFSET]
 #define IO_PortsSetOutput(port,i) *PORTS_TRISCLR[port][i-OFFSET] = PortsBits[port][i-OFFSET]
@@ -65,6 +95,18 @@ typedef union {
     uint16_t ui;
 } portBitField_T;
 
+typedef struct {
+    uint8_t phys;               // PHYS_x
+    uint16_t all;               // every pin of the IO port on this PIC32 port
+    uint16_t slice[NUMSLICES][1 << SLICE_BITS]; // physical bits for each slice of the pattern
+} portGroup_T;
+
+typedef struct {
+    uint32_t time;              // core timer at the change notification
+    uint16_t pattern;           // change notify pins of the port after the change
+    int8_t port;
+} edgeRecord_T;
+
 /*******************************************************************************
  * PRIVATE VARIABLES                                                           *
  ******************************************************************************/
@@ -122,6 +164,80 @@ static const uint16_t PortBits[][NUMPINS] = {
     {BIT_4, BIT_1, BIT_3, BIT_0, BIT_2, BIT_8, BIT_1, BIT_3, BIT_0, BIT_2}
 };
 #endif
+
+// SET/CLR/INV registers of each PIC32 port, indexed by PHYS_x
+static volatile unsigned int * const PHYS_TRISCLR[NUMPHYS] = {&TRISBCLR, &TRISDCLR, &TRISECLR, &TRISFCLR, &TRISGCLR};
+static volatile unsigned int * const PHYS_TRISSET[NUMPHYS] = {&TRISBSET, &TRISDSET, &TRISESET, &TRISFSET, &TRISGSET};
+static volatile unsigned int * const PHYS_LATCLR[NUMPHYS] = {&LATBCLR, &LATDCLR, &LATECLR, &LATFCLR, &LATGCLR};
+static volatile unsigned int * const PHYS_LATSET[NUMPHYS] = {&LATBSET, &LATDSET, &LATESET, &LATFSET, &LATGSET};
+static volatile unsigned int * const PHYS_LATINV[NUMPHYS] = {&LATBINV, &LATDINV, &LATEINV, &LATFINV, &LATGINV};
+
+// the same pin map as the tables above, grouped by PIC32 port so a pattern turns into
+// one mask per PIC32 port with NUMSLICES lookups. PortsGroups[PortsFirstGroup[port]]
+// up to PortsFirstGroup[port + 1] are the groups of a port.
+static const uint8_t PortsFirstGroup[NUMPORTS + 1] = {0, 1, 2, 6, 8, 11};
+
+static const portGroup_T PortsGroups[] = {
+    // PORTV
+    GROUP(PHYS_B, BIT_2, BIT_3, BIT_4, BIT_5, BIT_8, BIT_9, ZERO, ZERO, ZERO, ZERO),
+    // PORTW
+    GROUP(PHYS_B, BIT_11, BIT_10, BIT_13, BIT_12, BIT_15, BIT_14, ZERO, ZERO, ZERO, ZERO),
+    // PORTX
+    GROUP(PHYS_F, BIT_5, ZERO, ZERO, BIT_4, ZERO, BIT_6, ZERO, ZERO, ZERO, ZERO),
+    GROUP(PHYS_B, ZERO, BIT_0, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO),
+#ifdef JP_SPI_MASTER
+    GROUP(PHYS_G, ZERO, ZERO, BIT_6, ZERO, BIT_7, ZERO, BIT_8, ZERO, ZERO, ZERO),
+#else
+    GROUP(PHYS_G, ZERO, ZERO, BIT_6, ZERO, BIT_8, ZERO, BIT_7, ZERO, ZERO, ZERO),
+#endif
+    GROUP(PHYS_D, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, ZERO, BIT_7, BIT_4, BIT_6),
+    // PORTY
+    GROUP(PHYS_D, BIT_11, BIT_3, BIT_5, BIT_10, ZERO, BIT_9, ZERO, BIT_2, ZERO, BIT_1),
+    GROUP(PHYS_E, ZERO, ZERO, ZERO, ZERO, BIT_7, ZERO, BIT_6, ZERO, BIT_5, ZERO),
+    // PORTZ
+    GROUP(PHYS_E, BIT_4, ZERO, BIT_3, ZERO, BIT_2, ZERO, BIT_1, ZERO, BIT_0, ZERO),
+    GROUP(PHYS_F, ZERO, BIT_1, ZERO, ZERO, ZERO, ZERO, ZERO, BIT_3, ZERO, BIT_2),
+    GROUP(PHYS_D, ZERO, ZERO, ZERO, BIT_0, ZERO, BIT_8, ZERO, ZERO, ZERO, ZERO)
+};
+
+// change notification input for each pin, the 64 pin part only has CN0 to CN18
+#ifdef JP_SPI_MASTER
+static const uint8_t PortsCN[][NUMPINS] = {
+    {4, 5, 6, 7, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {NO_CN, NO_CN, NO_CN, NO_CN, 12, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {18, 2, 8, 17, 9, NO_CN, 10, 16, 13, 15},
+    {NO_CN, NO_CN, 14, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN}
+};
+#else
+static const uint8_t PortsCN[][NUMPINS] = {
+    {4, 5, 6, 7, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {NO_CN, NO_CN, NO_CN, NO_CN, 12, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {18, 2, 8, 17, 10, NO_CN, 9, 16, 13, 15},
+    {NO_CN, NO_CN, 14, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN},
+    {NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN, NO_CN}
+};
+#endif
+
+// edge ring, written only by the change notice interrupt and read only by
+// PortsDrainEdges, so head and tail each have a single writer and need no lock
+static volatile edgeRecord_T EdgeRing[EDGE_RING_SIZE];
+static volatile uint8_t EdgeHead = 0;
+static volatile uint8_t EdgeTail = 0;
+static uint16_t EdgeLast[NUMPORTS];    // last pattern pushed by the interrupt
+
+static uint16_t WatchPins[NUMPORTS];   // pins being debounced
+static uint16_t NotifyPins[NUMPORTS];  // watched pins with a CN input
+static uint16_t PolledPins[NUMPORTS];  // watched pins without one, sampled on read
+static uint16_t RawPins[NUMPORTS];     // latest undebounced pattern
+static uint16_t StablePins[NUMPORTS];  // debounced pattern
+static uint16_t SettlePins[NUMPORTS];  // raw differs from stable inside the lockout
+static uint32_t Lockout[NUMPORTS];     // core ticks
+static uint32_t ChangeTime[NUMPORTS][NUMPINS];
+
+static IO_PortsSnapshot_T Snapshot;
+static uint8_t SnapshotTaken = FALSE;
+
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
@@ -196,19 +312,54 @@ uint16_t PortReadZ(void);
  *         one function.
  * @note if the altregister pointer is NULL, then only the 1's on the pattern are
  *       used. Use this to handle functions where both 1's and 0's are important.
+ * @note The public functions go through PortsWriteMasks now, this is kept as the
+ *       reference the test harness checks and times it against.
  * @author Gabriel H Elkaim, 2013.10.19 21:49 */
 int8_t PortHandleHardwareIndirection(int8_t port, uint16_t pattern,
     volatile unsigned int * const portregister[][NUMPINS],
     volatile unsigned int * const altregister[][NUMPINS]);
 
+/**
+ * @Function PortsWriteMasks(int8_t port, uint16_t pattern,
+    volatile unsigned int * const physregister[], volatile unsigned int * const altregister[])
+ * @param port - #defined as PORTx [V, W, X, Y, or Z]
+ * @param pattern - valid from bits 3-8 [V,W] or 3-12 [X,Y,Z]
+ * @param physregister - PHYS_ table written with the 1's of the pattern
+ * @param altregister - PHYS_ table written with the 0's of the pattern, or NULL
+ * @return SUCCESS or ERROR
+ * @brief Same job as PortHandleHardwareIndirection, but looks the physical bits up in
+ *        PortsGroups and writes each PIC32 port once instead of once per pin. A port
+ *        with all of its pins on one PIC32 port takes one write, two with altregister. */
+static int8_t PortsWriteMasks(int8_t port, uint16_t pattern,
+    volatile unsigned int * const physregister[],
+    volatile unsigned int * const altregister[]);
+
+/**
+ * @Function PortsDebounce(int8_t port, uint16_t pattern, uint32_t time)
+ * @param port - #defined as PORTx [V, W, X, Y, or Z]
+ * @param pattern - raw watched pins of the port at time
+ * @param time - core timer when pattern was sampled
+ * @return None
+ * @brief Leading edge debounce: a pin that has been stable for the lockout takes
+ *        the new level at once, further changes inside the lockout are held off
+ *        and picked up once it expires if the pin has not come back. */
+static void PortsDebounce(int8_t port, uint16_t pattern, uint32_t time);
+
+/**
+ * @Function PortsDrainEdges(void)
+ * @param None
+ * @return None
+ * @brief Empties the edge ring into the debouncer, then samples the polled pins
+ *        and retries any pins that were held off by the lockout. */
+static void PortsDrainEdges(void);
+
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
  ******************************************************************************/
 
 int8_t IO_PortsSetPortDirection(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern,
-        PORTS_TRISSET, PORTS_TRISCLR) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_TRISSET, PHYS_TRISCLR) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -237,7 +388,7 @@ int8_t IO_PortsSetPortDirection(int8_t port, uint16_t pattern)
 
 int8_t IO_PortsSetPortInputs(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_TRISSET, NULL) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_TRISSET, NULL) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -264,7 +415,7 @@ int8_t IO_PortsSetPortInputs(int8_t port, uint16_t pattern)
 
 int8_t IO_PortsSetPortOutputs(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_TRISCLR, NULL) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_TRISCLR, NULL) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -319,7 +470,7 @@ int16_t IO_PortsReadPort(int8_t port)
 
 int8_t IO_PortsWritePort(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_LATSET, PORTS_LATCLR) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_LATSET, PHYS_LATCLR) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -348,7 +499,7 @@ int8_t IO_PortsWritePort(int8_t port, uint16_t pattern)
 
 int8_t IO_PortsSetPortBits(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_LATSET, NULL) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_LATSET, NULL) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -375,7 +526,7 @@ int8_t IO_PortsSetPortBits(int8_t port, uint16_t pattern)
 
 int8_t IO_PortsClearPortBits(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_LATCLR, NULL) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_LATCLR, NULL) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -402,7 +553,7 @@ int8_t IO_PortsClearPortBits(int8_t port, uint16_t pattern)
 
 int8_t IO_PortsTogglePortBits(int8_t port, uint16_t pattern)
 {
-    if (PortHandleHardwareIndirection(port, pattern, PORTS_LATINV, NULL) == ERROR) {
+    if (PortsWriteMasks(port, pattern, PHYS_LATINV, NULL) == ERROR) {
         dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
     } else {
         return SUCCESS;
@@ -427,6 +578,95 @@ int8_t IO_PortsTogglePortBits(int8_t port, uint16_t pattern)
     //    return SUCCESS;
 }
 
+int8_t IO_PortsEnableChangeNotify(int8_t port, uint16_t pattern, uint16_t debounceUs)
+{
+    uint8_t i;
+    uint32_t now;
+
+    if ((port < PORTV) || (port > PORTZ)) {
+        dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
+        return ERROR;
+    }
+    pattern &= (port <= PORTW) ? PORTVWMASK : PORTXYZMASK;
+    IEC1bits.CNIE = 0;
+    now = _CP0_GET_COUNT();
+    Lockout[port] = (uint32_t) debounceUs * CORE_TICKS_PER_US;
+    for (i = OFFSET; i < TOPXYZ; i++) {
+        if (pattern & (1 << i)) {
+            if (PortsCN[port][i - OFFSET] == NO_CN) {
+                PolledPins[port] |= (1 << i);
+            } else {
+                NotifyPins[port] |= (1 << i);
+                CNENSET = (1 << PortsCN[port][i - OFFSET]);
+            }
+            // allow the first edge through straight away
+            ChangeTime[port][i - OFFSET] = now - Lockout[port];
+        }
+    }
+    WatchPins[port] = NotifyPins[port] | PolledPins[port];
+    RawPins[port] = IO_PortsReadPort(port) & WatchPins[port];
+    StablePins[port] = RawPins[port];
+    SettlePins[port] = 0;
+    EdgeLast[port] = RawPins[port] & NotifyPins[port];
+    if (CNEN) {
+        CNCONbits.ON = 1;
+        IFS1bits.CNIF = 0;
+        IPC6bits.CNIP = 5;
+        IEC1bits.CNIE = 1;
+    }
+    return SUCCESS;
+}
+
+int16_t IO_PortsReadDebounced(int8_t port)
+{
+    if ((port < PORTV) || (port > PORTZ)) {
+        dbprintf("\nIO_Ports: %s failed, must be called with a single PORTx", __FUNCTION__);
+        return ERROR;
+    }
+    PortsDrainEdges();
+    return StablePins[port];
+}
+
+uint32_t IO_PortsGetChangeTime(int8_t port, uint16_t pin)
+{
+    uint8_t i;
+
+    if ((port < PORTV) || (port > PORTZ)) {
+        return 0;
+    }
+    for (i = OFFSET; i < TOPXYZ; i++) {
+        if (pin & (1 << i)) {
+            return ChangeTime[port][i - OFFSET];
+        }
+    }
+    return 0;
+}
+
+void IO_PortsTakeSnapshot(void)
+{
+    int8_t port;
+
+    PortsDrainEdges();
+    Snapshot.time = _CP0_GET_COUNT();
+    Snapshot.raw[PORTV] = PortReadV();
+    Snapshot.raw[PORTW] = PortReadW();
+    Snapshot.raw[PORTX] = PortReadX();
+    Snapshot.raw[PORTY] = PortReadY();
+    Snapshot.raw[PORTZ] = PortReadZ();
+    for (port = PORTV; port <= PORTZ; port++) {
+        Snapshot.debounced[port] = StablePins[port];
+    }
+    SnapshotTaken = TRUE;
+}
+
+const IO_PortsSnapshot_T *IO_PortsGetSnapshot(void)
+{
+    if (!SnapshotTaken) {
+        IO_PortsTakeSnapshot();
+    }
+    return &Snapshot;
+}
+
 /*******************************************************************************
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
@@ -503,6 +743,76 @@ uint16_t PortReadZ(void)
     return (portZ.ui);
 }
 
+static void PortsDebounce(int8_t port, uint16_t pattern, uint32_t time)
+{
+    uint8_t i;
+    uint16_t changed;
+
+    RawPins[port] = pattern;
+    changed = (pattern ^ StablePins[port]) & WatchPins[port];
+    for (i = OFFSET; (i < TOPXYZ) && changed; i++) {
+        if (changed & (1 << i)) {
+            if ((time - ChangeTime[port][i - OFFSET]) >= Lockout[port]) {
+                StablePins[port] ^= (1 << i);
+                ChangeTime[port][i - OFFSET] = time;
+            }
+            changed &= ~(1 << i);
+        }
+    }
+    SettlePins[port] = (RawPins[port] ^ StablePins[port]) & WatchPins[port];
+}
+
+static void PortsDrainEdges(void)
+{
+    volatile edgeRecord_T *edge;
+    uint16_t pattern;
+    int8_t port;
+
+    while (EdgeTail != EdgeHead) {
+        edge = &EdgeRing[EdgeTail & EDGE_RING_MASK];
+        pattern = (RawPins[edge->port] & PolledPins[edge->port]) | edge->pattern;
+        PortsDebounce(edge->port, pattern, edge->time);
+        EdgeTail++;
+    }
+    for (port = PORTV; port <= PORTZ; port++) {
+        if (PolledPins[port] || SettlePins[port]) {
+            pattern = RawPins[port] & NotifyPins[port];
+            if (PolledPins[port]) {
+                pattern |= IO_PortsReadPort(port) & PolledPins[port];
+            }
+            PortsDebounce(port, pattern, _CP0_GET_COUNT());
+        }
+    }
+}
+
+/**
+ * @Function ChangeNoticeIntHandler
+ * @brief Timestamps the change and pushes the new pattern of every port with
+ *        change notify pins onto the edge ring. Reading the ports also clears
+ *        the mismatch condition. If the ring is full the record is dropped,
+ *        later records carry the whole pattern so only the glitch is lost.
+ * @note This function is not to be called by the user */
+void __ISR(_CHANGE_NOTICE_VECTOR) ChangeNoticeIntHandler(void)
+{
+    uint32_t now = _CP0_GET_COUNT();
+    uint16_t pattern;
+    int8_t port;
+
+    for (port = PORTV; port <= PORTZ; port++) {
+        if (NotifyPins[port]) {
+            pattern = IO_PortsReadPort(port) & NotifyPins[port];
+            if ((pattern != EdgeLast[port]) && ((uint8_t) (EdgeHead - EdgeTail) < EDGE_RING_SIZE)) {
+                EdgeRing[EdgeHead & EDGE_RING_MASK].time = now;
+                EdgeRing[EdgeHead & EDGE_RING_MASK].pattern = pattern;
+                EdgeRing[EdgeHead & EDGE_RING_MASK].port = port;
+                EdgeHead++;
+                EdgeLast[port] = pattern;
+            }
+        }
+    }
+    IFS1bits.CNIF = 0;
+}
+
 /**
  * @Function: PortHandleHardwareIndirection(char port, unsigned short pattern, 
     static volatile unsigned int * const portregister, const char * fname)
@@ -549,6 +859,34 @@ int8_t PortHandleHardwareIndirection(int8_t port, uint16_t pattern,
 
 }
 
+static int8_t PortsWriteMasks(int8_t port, uint16_t pattern,
+    volatile unsigned int * const physregister[],
+    volatile unsigned int * const altregister[])
+{
+    const portGroup_T *group;
+    const portGroup_T *last;
+    uint16_t mask;
+
+    if ((port < PORTV) || (port > PORTZ)) { // test if port is within range
+        return ERROR;
+    }
+    // no masking needed, pins a port does not have are ZERO in its groups
+    pattern >>= OFFSET;
+    last = &PortsGroups[PortsFirstGroup[port + 1]];
+    for (group = &PortsGroups[PortsFirstGroup[port]]; group < last; group++) {
+        mask = group->slice[0][pattern & SLICE_MASK]
+            | group->slice[1][(pattern >> SLICE_BITS) & SLICE_MASK]
+            | group->slice[2][(pattern >> (2 * SLICE_BITS)) & SLICE_MASK];
+        if (mask) {
+            *physregister[group->phys] = mask;
+        }
+        if ((altregister != NULL) && (mask != group->all)) {
+            *altregister[group->phys] = group->all & ~mask;
+        }
+    }
+    return SUCCESS;
+}
+
 /*******************************************************************************
  * TEST HARNESS                                                                *
  ******************************************************************************/
@@ -566,6 +904,71 @@ int8_t PortHandleHardwareIndirection(int8_t port, uint16_t pattern,
 #define NUM2REPEAT  10
 #define OUTPUTPORT PORTY
 #define INPUTPORT PORTX
+#define BENCH_CALLS 1000
+
+static volatile unsigned int * const TestLats[NUMPHYS] = {&LATB, &LATD, &LATE, &LATF, &LATG};
+
+/* Compares every LAT register after writing the pattern through the per pin tables and
+ * through PortsGroups, returns the number of registers that differ.
+ */
+int TestMasks(int8_t port, uint16_t pattern)
+{
+    uint32_t expected[NUMPHYS];
+    int i, errors = 0;
+
+    PortHandleHardwareIndirection(port, pattern, PORTS_LATSET, PORTS_LATCLR);
+    for (i = 0; i < NUMPHYS; i++) {
+        expected[i] = *TestLats[i];
+    }
+    IO_PortsWritePort(port, ~pattern);
+    IO_PortsWritePort(port, pattern);
+    for (i = 0; i < NUMPHYS; i++) {
+        if (*TestLats[i] != expected[i]) {
+            errors++;
+        }
+    }
+    IO_PortsClearPortBits(port, 0xFFFF);
+    IO_PortsSetPortBits(port, pattern);
+    for (i = 0; i < NUMPHYS; i++) {
+        if (*TestLats[i] != expected[i]) {
+            errors++;
+        }
+    }
+    return errors;
+}
+
+/* Core timer ticks (2 CPU cycles each) per call of IO_PortsSetPortBits and of the per
+ * pin loop it replaced, and the same for IO_PortsWritePort.
+ */
+void TestBenchmark(int8_t port, uint16_t pattern, char label)
+{
+    uint32_t start, loopSet, maskSet, loopWrite, maskWrite;
+    int j;
+
+    start = _CP0_GET_COUNT();
+    for (j = 0; j < BENCH_CALLS; j++) {
+        PortHandleHardwareIndirection(port, pattern, PORTS_LATSET, NULL);
+    }
+    loopSet = _CP0_GET_COUNT() - start;
+    start = _CP0_GET_COUNT();
+    for (j = 0; j < BENCH_CALLS; j++) {
+        IO_PortsSetPortBits(port, pattern);
+    }
+    maskSet = _CP0_GET_COUNT() - start;
+    start = _CP0_GET_COUNT();
+    for (j = 0; j < BENCH_CALLS; j++) {
+        PortHandleHardwareIndirection(port, pattern, PORTS_LATSET, PORTS_LATCLR);
+    }
+    loopWrite = _CP0_GET_COUNT() - start;
+    start = _CP0_GET_COUNT();
+    for (j = 0; j < BENCH_CALLS; j++) {
+        IO_PortsWritePort(port, pattern);
+    }
+    maskWrite = _CP0_GET_COUNT() - start;
+    printf("\nPORT%c [0x%04X] set bits: %lu ticks per pin, %lu masked, write port: %lu per pin, %lu masked",
+        label, pattern, (unsigned long) (loopSet / BENCH_CALLS), (unsigned long) (maskSet / BENCH_CALLS),
+        (unsigned long) (loopWrite / BENCH_CALLS), (unsigned long) (maskWrite / BENCH_CALLS));
+}
 
 /* Testing function is just a pointer to function wrapper to make the testing harness
  * take less space to implement.
@@ -642,6 +1045,25 @@ int main(void)
     }
     DELAY(A_BIT);
 
+    //
+    // Check the masked writes against the per pin tables, then time both. The LAT
+    // registers are written with every port still an input, so no pins move.
+    //
+    printf("\n\nChecking masked writes against PortHandleHardwareIndirection\n");
+    for (k = PORTV; k <= PORTZ; k++) {
+        j = 0;
+        for (pattern = 0; pattern <= PORTXYZMASK; pattern += PIN3) {
+            j += TestMasks(k, pattern);
+        }
+        printf("\nPORT%c, every pattern: %s", portLabel[k], (j == 0) ? "PASSED" : "FAILED");
+    }
+    printf("\n\nCore timer ticks per call, %u calls each", BENCH_CALLS);
+    for (k = PORTV; k <= PORTZ; k++) {
+        TestBenchmark(k, (k <= PORTW) ? PORTVWMASK : PORTXYZMASK, portLabel[k]);
+    }
+    TestBenchmark(PORTX, PIN11 | PIN12, 'X');
+    DELAY(A_BIT);
+
     //
     // Test that all ports can be turned into outputs successfully
     //
@@ -28,6 +28,19 @@
  * IO_PortsClearPortBits(PORTx, Pattern) - Pattern: 1's set low, 0's ignored
  * IO_PortsTogglePortBits(PORTx, Pattern) - Pattern: 1's toggled, 0's ignored
  *
+ * Inputs that need debouncing (bumpers, switches) can be handed to the change notify
+ * interrupt instead of being polled:
+ *
+ * IO_PortsEnableChangeNotify(PORTx, Pattern, DebounceUs) - Pattern: 1's are watched
+ * IO_PortsReadDebounced(PORTx) - debounced level of the watched pins
+ * IO_PortsGetChangeTime(PORTx, Pin) - core timer count of the last debounced change
+ *
+ * Sensor code that runs on the control tick reads a snapshot of all five ports instead
+ * of going to the pins itself, so every checker in a tick sees the same inputs:
+ *
+ * IO_PortsTakeSnapshot() - once at the start of the tick, raw and debounced patterns
+ * IO_PortsGetSnapshot() - the last snapshot
+ *
  * where PORTx are the #defined ports where x is V,W,X,Y, or Z
  * Pattern matches the pin outs on the IO board, that is that the only bits that
  * correspond to pin outs are used (e.g. bits 3 to 8 for V&W or bits 3 to 12 for XY&Z)
@@ -60,6 +73,7 @@
 #define PORTX 2
 #define PORTY 3
 #define PORTZ 4
+#define NUM_IO_PORTS 5
 
 //PORT V
 #define PORTV03_TRIS TRISBbits.TRISB2
@@ -235,6 +249,16 @@
 #define PIN11 0x0800  //0b0000 1000 0000 0000 - BIT 11
 #define PIN12 0x1000  //0b0001 0000 0000 0000 - BIT 12
 
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    uint32_t time;                      // core timer (_CP0_GET_COUNT) when the ports were read
+    uint16_t raw[NUM_IO_PORTS];         // IO_PortsReadPort pattern, indexed by PORTx
+    uint16_t debounced[NUM_IO_PORTS];   // IO_PortsReadDebounced pattern, indexed by PORTx
+} IO_PortsSnapshot_T;
+
 /*******************************************************************************
  * PUBLIC FUNCTION PROTOTYPES                                                  *
  ******************************************************************************/
@@ -336,4 +360,54 @@ int8_t IO_PortsClearPortBits(int8_t port, uint16_t pattern);
  * @author Gabriel Hugh Elkaim, 2012.01.06 21:22 */
 int8_t IO_PortsTogglePortBits(int8_t port, uint16_t pattern);
 
+/**
+ * Function: IO_PortsEnableChangeNotify(char port, unsigned short pattern, unsigned short debounceUs);
+ * @param port, use #defined PORTx [V,W,X,Y,Z]
+ * @param pattern, bit pattern: 0 - ignore, 1 - watch pin
+ * @param debounceUs, lockout after a debounced change in microseconds
+ * @return SUCCESS or ERROR
+ * @brief Function enables the change notify interrupt on each watched pin. The
+ *        interrupt timestamps every change into an edge ring and the ring is
+ *        debounced when the port is read with IO_PortsReadDebounced. The first
+ *        edge is taken at once, edges inside the lockout that follow are ignored.
+ * @note Pins with no change notify input (X08 and most of Y and Z) are still
+ *       watched, but are sampled on each read rather than by the interrupt.
+ *       Pins should already be set as inputs. */
+int8_t IO_PortsEnableChangeNotify(int8_t port, uint16_t pattern, uint16_t debounceUs);
+
+/**
+ * Function: IO_PortsReadDebounced(char port);
+ * @param port, use #defined PORTx [V,W,X,Y,Z]
+ * @return Debounced bit pattern of the watched pins on port, or ERROR
+ * @brief Function runs the pending edges through the debouncer and returns the
+ *        debounced level of the pins watched with IO_PortsEnableChangeNotify.
+ *        Unwatched pins read as 0. With no edges waiting only the polled pins
+ *        are sampled, so it is cheap enough to call on every pass. */
+int16_t IO_PortsReadDebounced(int8_t port);
+
+/**
+ * Function: IO_PortsGetChangeTime(char port, unsigned short pin);
+ * @param port, use #defined PORTx [V,W,X,Y,Z]
+ * @param pin, use #defined PINx, only the lowest set pin is used
+ * @return core timer count (_CP0_GET_COUNT) of the last debounced change
+ * @brief Edge time as captured in the change notify interrupt, for polled pins
+ *        it is the time of the read that saw the change. */
+uint32_t IO_PortsGetChangeTime(int8_t port, uint16_t pin);
+
+/**
+ * Function: IO_PortsTakeSnapshot(void);
+ * @param None
+ * @return None
+ * @brief Runs the pending edges through the debouncer, then reads PORTV to PORTZ back
+ *        to back. Call once at the start of the control tick, before the checkers. */
+void IO_PortsTakeSnapshot(void);
+
+/**
+ * Function: IO_PortsGetSnapshot(void);
+ * @param None
+ * @return pointer to the last snapshot, valid until the next IO_PortsTakeSnapshot
+ * @brief Takes the first snapshot if none has been taken yet, so sensors read during
+ *        init see the pins as they are. */
+const IO_PortsSnapshot_T *IO_PortsGetSnapshot(void);
+
 #endif
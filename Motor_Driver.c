@@ -20,6 +20,7 @@
 /* Section: Included Files                                                    */
 /* ************************************************************************** */
 /* ************************************************************************** */
+#ifndef MOTOR_RAMP_SIM
 #include "Motor_Driver.h"
 
 #include "BOARD.h"
@@ -31,6 +32,11 @@
 #include <xc.h>
 #include <stdio.h>
 #include <stdint.h>
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#endif
 
 //#define MotorTests
 #define ALL_16Bits 0xFFFF
@@ -50,12 +56,54 @@
 #define IN3 PIN5
 #define IN4 PIN6
 
+//IN1 to IN4 behind the IO board, see PORTX11, PORTX12, PORTX05 and PORTX06 in IO_Ports.h
+#define IN1_LATD _LATD_LATD4_MASK
+#define IN2_LATD _LATD_LATD6_MASK
+#define IN3_LATG _LATG_LATG6_MASK
+#define IN4_LATF _LATF_LATF4_MASK
+
 //Below References PORTZ
 #define IN5 PIN5
 #define IN6 PIN9
 #define IN7 PIN7
 #define IN8 PIN8
 
+//index into MotorLoad
+#define LEFT_WHEEL_LOAD 0
+#define RIGHT_WHEEL_LOAD 1
+#define LEFT_FLYWHEEL_LOAD 2
+#define RIGHT_FLYWHEEL_LOAD 3
+#define NUM_MOTORS 4
+
+//the flywheels run from Timer3 so the two frequencies can be tuned apart
+#define DRIVE_PWM_FREQ MIN_PWM_FREQ
+#define FLYWHEEL_PWM_FREQ MIN_PWM_FREQ
+
+#define NO_COMMAND (MAX_FORWARD + 1)    //forces the first write after Motors_Init
+
+#define RAMP_MAX_MS 50                  //a late tick moves the wheels no further than this
+
+static int32_t Drive_RampToward(int32_t Actual, int Target, unsigned int Accel, unsigned int Decel,
+        unsigned int ElapsedMs);
+
+#ifndef MOTOR_RAMP_SIM
+static unsigned int MotorLoad[NUM_MOTORS];     //last commanded |PWM|, after the throttle
+static unsigned char Throttle = 100;            //percent, drive wheels only
+static unsigned int SkewTicks = 0;              //time the last Drive_SetWheels held interrupts off
+static int LastCommand[NUM_MOTORS] = {NO_COMMAND, NO_COMMAND, NO_COMMAND, NO_COMMAND};
+static unsigned int WritesIssued = 0;
+static unsigned int WritesElided = 0;
+
+static unsigned char Ramping = FALSE;
+static unsigned int RampAccel;                  //PWM per second, away from zero
+static unsigned int RampDecel;                  //PWM per second, toward zero
+static int RampTarget[2];                       //drive wheels, before the throttle
+static int32_t RampActual[2];                   //thousandths of PWM
+static uint32_t RampLast;
+
+static char Motors_IsNewCommand(unsigned char Motor, int PWM);
+static char Drive_Apply(int Left, int Right);
+
 
 
  
@@ -69,6 +117,7 @@
  * @author Leo King 5/16/2023
  **/
 char Motors_Init(void) {
+    unsigned char Motor;
     char returnVal = PWM_Init();
     if (returnVal == ERROR) {
         return ERROR;
@@ -78,7 +127,9 @@ char Motors_Init(void) {
     PWM_AddPins(Left_FlyWheel_PWM);                //ENA For H-Bridge Left Wheel
     PWM_AddPins(Right_FlyWheel_PWM);               //ENB For H-Bridge Right Wheel
     
-    PWM_SetFrequency(MIN_PWM_FREQ);
+    PWM_SetFrequency(DRIVE_PWM_FREQ);
+    PWM_SetGroupFrequency(PWM_TIMER3, FLYWHEEL_PWM_FREQ);
+    PWM_SetGroup(Left_FlyWheel_PWM | Right_FlyWheel_PWM, PWM_TIMER3);
     PWM_SetDutyCycle(Left_Wheel_PWM, MIN_PWM);  //Turn Motor Speed to Zero
     PWM_SetDutyCycle(Right_Wheel_PWM, MIN_PWM); //Turn Motor Speed to Zero
     
@@ -94,6 +145,9 @@ char Motors_Init(void) {
     //Initialize Both Wheels Directions to Forward
     IO_PortsWritePort(PORTX, IN1 | IN3);
     IO_PortsWritePort(PORTZ, IN5 | IN7);
+    for (Motor = 0; Motor < NUM_MOTORS; Motor++) {
+        LastCommand[Motor] = NO_COMMAND;
+    }
     
     return SUCCESS;
 }
@@ -111,6 +165,15 @@ int LeftWheelSpeed(int PWM) {
     if ((PWM > MAX_FORWARD) || (PWM < MAX_REVERSE)) {
         return FALSE;
     }
+    if (Ramping) {
+        RampTarget[LEFT_WHEEL_LOAD] = PWM;
+        return TRUE;
+    }
+    PWM = (PWM * (int) Throttle) / 100;
+    MotorLoad[LEFT_WHEEL_LOAD] = (PWM >= 0) ? PWM : -PWM;
+    if (!Motors_IsNewCommand(LEFT_WHEEL_LOAD, PWM)) {
+        return TRUE;
+    }
     //Forward
     if (PWM >= 0) {                     
         IO_PortsSetPortBits(PORTX, IN2);
@@ -139,6 +202,15 @@ int RightWheelSpeed(int PWM) {
         if ((PWM > MAX_FORWARD) || (PWM < MAX_REVERSE)) {
         return FALSE;
     }
+    if (Ramping) {
+        RampTarget[RIGHT_WHEEL_LOAD] = PWM;
+        return TRUE;
+    }
+    PWM = (PWM * (int) Throttle) / 100;
+    MotorLoad[RIGHT_WHEEL_LOAD] = (PWM >= 0) ? PWM : -PWM;
+    if (!Motors_IsNewCommand(RIGHT_WHEEL_LOAD, PWM)) {
+        return TRUE;
+    }
     //Forward
     if (PWM >= 0) {                     
         IO_PortsSetPortBits(PORTX, IN4);
@@ -167,6 +239,10 @@ int LeftFlyWheelSpeed(int PWM) {
     if ((PWM > MAX_FORWARD) || (PWM < MAX_REVERSE)) {
         return FALSE;
     }
+    MotorLoad[LEFT_FLYWHEEL_LOAD] = (PWM >= 0) ? PWM : -PWM;
+    if (!Motors_IsNewCommand(LEFT_FLYWHEEL_LOAD, PWM)) {
+        return TRUE;
+    }
     //Forward
     if (PWM >= 0) {                     
         IO_PortsSetPortBits(PORTZ, IN5);
@@ -186,6 +262,10 @@ int RightFlyWheelSpeed(int PWM) {
     if ((PWM > MAX_FORWARD) || (PWM < MAX_REVERSE)) {
         return FALSE;
     }
+    MotorLoad[RIGHT_FLYWHEEL_LOAD] = (PWM >= 0) ? PWM : -PWM;
+    if (!Motors_IsNewCommand(RIGHT_FLYWHEEL_LOAD, PWM)) {
+        return TRUE;
+    }
     //Forward
     if (PWM >= 0) {                     
         IO_PortsSetPortBits(PORTZ, IN7);
@@ -201,6 +281,230 @@ int RightFlyWheelSpeed(int PWM) {
     return TRUE;
 }
 
+/**
+ * @Function Motors_SetThrottle(unsigned char Percent)
+ * @param Percent - 0 to 100, scales every later drive wheel command
+ * @return SUCCESS or ERROR
+ * @brief Used to cut the drive current on a low battery. The flywheels are left at
+ *        full speed so a shot in progress still lands. Takes effect on the next call
+ *        to LeftWheelSpeed or RightWheelSpeed. */
+char Motors_SetThrottle(unsigned char Percent) {
+    if (Percent > 100) {
+        return ERROR;
+    }
+    Throttle = Percent;
+    return SUCCESS;
+}
+
+/**
+ * @Function Motors_GetLoad(void)
+ * @param none
+ * @return sum of the commanded |PWM| of all four motors, 0 to 4000
+ * @brief A rough stand-in for the battery current, used to correct the battery
+ *        voltage for sag. */
+unsigned int Motors_GetLoad(void) {
+    return MotorLoad[LEFT_WHEEL_LOAD] + MotorLoad[RIGHT_WHEEL_LOAD]
+            + MotorLoad[LEFT_FLYWHEEL_LOAD] + MotorLoad[RIGHT_FLYWHEEL_LOAD];
+}
+
+/**
+ * @Function Drive_SetWheels(int Left, int Right)
+ * @param Left, Right - wheel commands from -1000 to 1000
+ * @return SUCCESS or ERROR, nothing is changed for an out of range command
+ * @brief Sets both wheels together, or their targets while ramping */
+char Drive_SetWheels(int Left, int Right) {
+    if ((Left > MAX_FORWARD) || (Left < MAX_REVERSE) || (Right > MAX_FORWARD) || (Right < MAX_REVERSE)) {
+        return ERROR;
+    }
+    if (Ramping) {
+        RampTarget[LEFT_WHEEL_LOAD] = Left;
+        RampTarget[RIGHT_WHEEL_LOAD] = Right;
+        return SUCCESS;
+    }
+    return Drive_Apply(Left, Right);
+}
+
+/**
+ * @Function Drive_SetRamp(unsigned int Accel, unsigned int Decel)
+ * @param Accel - PWM per second a wheel may speed up by
+ * @param Decel - PWM per second a wheel may slow down by, a reversal slows to zero
+ *        at this rate and then speeds up at Accel
+ * @return SUCCESS, or ERROR with only one of them zero, which leaves the ramp off
+ * @brief With both at zero the wheel commands go straight to the hardware again. The
+ *        ramp starts from the wheels' last commands. */
+char Drive_SetRamp(unsigned int Accel, unsigned int Decel) {
+    unsigned char Wheel;
+
+    Ramping = FALSE;
+    if ((Accel == 0) && (Decel == 0)) {
+        return SUCCESS;
+    }
+    //a zero limit would hold that wheel where it is for good
+    if ((Accel == 0) || (Decel == 0)) {
+        return ERROR;
+    }
+    RampAccel = Accel;
+    RampDecel = Decel;
+    for (Wheel = LEFT_WHEEL_LOAD; Wheel <= RIGHT_WHEEL_LOAD; Wheel++) {
+        if ((LastCommand[Wheel] == NO_COMMAND) || (Throttle == 0)) {
+            RampTarget[Wheel] = 0;
+        } else {
+            RampTarget[Wheel] = (LastCommand[Wheel] * 100) / (int) Throttle;
+        }
+        RampActual[Wheel] = (int32_t) RampTarget[Wheel] * 1000;
+    }
+    RampLast = _CP0_GET_COUNT();
+    Ramping = TRUE;
+    return SUCCESS;
+}
+
+/**
+ * @Function Drive_RampTick(void)
+ * @param none
+ * @return None
+ * @brief Moves both drive wheels toward their targets by the time since the last
+ *        tick. Unchanged commands are not written, so a settled ramp costs nothing. */
+void Drive_RampTick(void) {
+    uint32_t Elapsed;
+
+    if (!Ramping) {
+        return;
+    }
+    Elapsed = (_CP0_GET_COUNT() - RampLast) / CORE_TICKS_PER_MS;
+    if (Elapsed == 0) {
+        return;
+    }
+    //keep the part of a millisecond left over for the next tick
+    RampLast += Elapsed * CORE_TICKS_PER_MS;
+    if (Elapsed > RAMP_MAX_MS) {
+        Elapsed = RAMP_MAX_MS;
+    }
+    RampActual[LEFT_WHEEL_LOAD] = Drive_RampToward(RampActual[LEFT_WHEEL_LOAD], RampTarget[LEFT_WHEEL_LOAD],
+            RampAccel, RampDecel, Elapsed);
+    RampActual[RIGHT_WHEEL_LOAD] = Drive_RampToward(RampActual[RIGHT_WHEEL_LOAD], RampTarget[RIGHT_WHEEL_LOAD],
+            RampAccel, RampDecel, Elapsed);
+    Drive_Apply(RampActual[LEFT_WHEEL_LOAD] / 1000, RampActual[RIGHT_WHEEL_LOAD] / 1000);
+}
+
+/**
+ * @Function Drive_Apply(int Left, int Right)
+ * @param Left, Right - wheel commands from -1000 to 1000
+ * @return SUCCESS or ERROR, nothing is changed for an out of range command
+ * @brief Works out both direction pin patterns and both duty cycles first, then
+ *        stages the duty cycles, which change together in the next PWM period, and
+ *        writes one CLR and one SET per LAT register with interrupts held off. Calling
+ *        LeftWheelSpeed and then RightWheelSpeed leaves one wheel on its old command
+ *        for the whole of the second call. */
+static char Drive_Apply(int Left, int Right) {
+    unsigned int Duty[NUM_PWM_CHANNELS];
+    unsigned int SetD, ClrD, SetF, ClrF, SetG, ClrG;
+    unsigned int Interrupts;
+    uint32_t Start;
+    char Result;
+
+    if ((Left > MAX_FORWARD) || (Left < MAX_REVERSE) || (Right > MAX_FORWARD) || (Right < MAX_REVERSE)) {
+        return ERROR;
+    }
+    Left = (Left * (int) Throttle) / 100;
+    Right = (Right * (int) Throttle) / 100;
+    MotorLoad[LEFT_WHEEL_LOAD] = (Left >= 0) ? Left : -Left;
+    MotorLoad[RIGHT_WHEEL_LOAD] = (Right >= 0) ? Right : -Right;
+    //both or neither, a single changed wheel still goes out with its partner
+    if ((LastCommand[LEFT_WHEEL_LOAD] == Left) && (LastCommand[RIGHT_WHEEL_LOAD] == Right)) {
+        WritesElided += 2;
+        return SUCCESS;
+    }
+    LastCommand[LEFT_WHEEL_LOAD] = Left;
+    LastCommand[RIGHT_WHEEL_LOAD] = Right;
+    WritesIssued += 2;
+    //same trim on the left wheel as LeftWheelSpeed
+    Duty[PWM_CHANNEL_Y10] = (925 * MotorLoad[LEFT_WHEEL_LOAD]) / 1000;
+    Duty[PWM_CHANNEL_Y12] = MotorLoad[RIGHT_WHEEL_LOAD];
+    SetD = (Left >= 0) ? IN2_LATD : IN1_LATD;
+    ClrD = (Left >= 0) ? IN1_LATD : IN2_LATD;
+    SetF = (Right >= 0) ? IN4_LATF : 0;
+    ClrF = (Right >= 0) ? 0 : IN4_LATF;
+    SetG = (Right >= 0) ? 0 : IN3_LATG;
+    ClrG = (Right >= 0) ? IN3_LATG : 0;
+
+    Interrupts = __builtin_disable_interrupts();
+    Start = _CP0_GET_COUNT();
+    Result = PWM_SetDutyCycles(Left_Wheel_PWM | Right_Wheel_PWM, Duty);
+    LATDCLR = ClrD;
+    LATFCLR = ClrF;
+    LATGCLR = ClrG;
+    LATDSET = SetD;
+    LATFSET = SetF;
+    LATGSET = SetG;
+    SkewTicks = _CP0_GET_COUNT() - Start;
+    if (Interrupts & 0x1) {
+        __builtin_enable_interrupts();
+    }
+    return Result;
+}
+
+/**
+ * @Function Drive_Set(int Speed, int Turn)
+ * @param Speed - forward command, -1000 to 1000
+ * @param Turn - added to the right wheel and taken from the left, positive turns left
+ * @return SUCCESS or ERROR
+ * @brief Speed is cut back when a wheel would go past full scale, so the turn is kept */
+char Drive_Set(int Speed, int Turn) {
+    int Limit;
+
+    if (Turn > MAX_FORWARD) {
+        Turn = MAX_FORWARD;
+    } else if (Turn < MAX_REVERSE) {
+        Turn = MAX_REVERSE;
+    }
+    Limit = MAX_FORWARD - ((Turn >= 0) ? Turn : -Turn);
+    if (Speed > Limit) {
+        Speed = Limit;
+    } else if (Speed < -Limit) {
+        Speed = -Limit;
+    }
+    return Drive_SetWheels(Speed - Turn, Speed + Turn);
+}
+
+/**
+ * @Function Motors_GetSkewTicks(void)
+ * @param none
+ * @return core timer ticks (25 ns) the last Drive_SetWheels spent writing the wheels
+ *         with interrupts off. The direction pins change inside it, the duty cycles
+ *         are committed together at a PWM period boundary. */
+unsigned int Motors_GetSkewTicks(void) {
+    return SkewTicks;
+}
+
+/**
+ * @Function Motors_GetWriteCounts(unsigned int *Issued, unsigned int *Elided)
+ * @param Issued - set to the wheel commands that reached the hardware
+ * @param Elided - set to the commands skipped because nothing had changed
+ * @return None
+ * @brief Counted per motor since power up. Each issued command is two direction pin
+ *        writes and a duty cycle write. */
+void Motors_GetWriteCounts(unsigned int *Issued, unsigned int *Elided) {
+    *Issued = WritesIssued;
+    *Elided = WritesElided;
+}
+
+/**
+ * @Function Motors_IsNewCommand(unsigned char Motor, int PWM)
+ * @param Motor - index into MotorLoad
+ * @param PWM - command after the throttle
+ * @return TRUE if the hardware needs writing, the command is then remembered
+ * @brief The FSMs repeat the same command on every event, including each 3 ms tape
+ *        timer, so most calls change nothing. */
+static char Motors_IsNewCommand(unsigned char Motor, int PWM) {
+    if (LastCommand[Motor] == PWM) {
+        WritesElided++;
+        return FALSE;
+    }
+    LastCommand[Motor] = PWM;
+    WritesIssued++;
+    return TRUE;
+}
+
 void TurnLeft(int PWM) {
     RightWheelSpeed(PWM);
     LeftWheelSpeed(-PWM);
@@ -222,12 +526,165 @@ int main(void) {
     //LeftWheelSpeed(200);
     RightFlyWheelSpeed(-500);
     LeftFlyWheelSpeed(500);
+
+    //window where one drive wheel has the new command and the other the old one
+    uint32_t Start = _CP0_GET_COUNT();
+    LeftWheelSpeed(-600);
+    RightWheelSpeed(600);
+    printf("Left then Right: %u ticks\r\n", (unsigned int) (_CP0_GET_COUNT() - Start));
+    Drive_SetWheels(600, -600);
+    printf("Drive_SetWheels: %u ticks\r\n", Motors_GetSkewTicks());
+    Drive_SetWheels(0, 0);
     while(1) {
         ;//printf("Read PORTX: %u\r\n", IO_PortsReadPort(PORTX));
     }
     BOARD_End();
 }
 #endif
+#endif /* MOTOR_RAMP_SIM */
+
+/**
+ * @Function Drive_RampToward(int32_t Actual, int Target, unsigned int Accel,
+ *           unsigned int Decel, unsigned int ElapsedMs)
+ * @param Actual - current command in thousandths of PWM
+ * @param Target - command to move toward, PWM
+ * @param Accel, Decel - PWM per second away from and toward zero
+ * @param ElapsedMs - time to move for
+ * @return new command in thousandths of PWM
+ * @brief A reversal stops at zero for the rest of the tick, the next tick speeds up
+ *        in the new direction. */
+static int32_t Drive_RampToward(int32_t Actual, int Target, unsigned int Accel, unsigned int Decel,
+        unsigned int ElapsedMs) {
+    int32_t Goal = (int32_t) Target * 1000;
+    int32_t Stop;
+
+    //slowing down, or on the way through zero
+    if (((Actual > 0) && (Goal < Actual)) || ((Actual < 0) && (Goal > Actual))) {
+        if (Actual > 0) {
+            Stop = (Goal > 0) ? Goal : 0;
+            Actual -= (int32_t) Decel * ElapsedMs;
+            return (Actual < Stop) ? Stop : Actual;
+        }
+        Stop = (Goal < 0) ? Goal : 0;
+        Actual += (int32_t) Decel * ElapsedMs;
+        return (Actual > Stop) ? Stop : Actual;
+    }
+    if (Goal > Actual) {
+        Actual += (int32_t) Accel * ElapsedMs;
+        return (Actual > Goal) ? Goal : Actual;
+    }
+    Actual -= (int32_t) Accel * ElapsedMs;
+    return (Actual < Goal) ? Goal : Actual;
+}
+
+#ifdef MOTOR_RAMP_SIM
+/*
+ * Timed pivots on a drive model with limited traction, built on a PC with
+ *     gcc -DMOTOR_RAMP_SIM Motor_Driver.c -o rampsim -lm
+ * Each wheel's motor follows its command with a first order lag, but the ground speed
+ * can only change as fast as the tyre grip allows, the rest is wheel slip. The grip
+ * varies from run to run (floor, battery, tyre wear). Every run enters the pivot from
+ * one of the FSM's states (stopped, full forward, full reverse as after a bumper)
+ * and commands a 1000/-1000 pivot for SIM_TURN_MS, then stops. The spread of the
+ * heading reached is what makes the timed turns unrepeatable.
+ */
+#define SIM_STEP_MS 1
+#define SIM_TICK_MS 3                   //TAPE_SERVICE_TIMER rate the ramp runs at
+#define SIM_MM_PER_S_PER_PWM 0.5
+#define SIM_WHEELBASE_MM 220.0
+#define SIM_MOTOR_TAU_S 0.08
+#define SIM_GRIP_MM_PER_S2 2000.0       //nominal, each run is 75 to 125 percent of this
+#define SIM_TURN_MS 400
+#define SIM_RUNS 60
+
+static unsigned long SimSeed = 118;
+
+static double SimRandom(void)
+{
+    SimSeed = SimSeed * 1103515245UL + 12345UL;
+    return (double) ((SimSeed >> 16) & 0x7FFF) / 0x7FFF;
+}
+
+static double SimWheel(double Speed, double Command, double Grip)
+{
+    double Accel = (Command * SIM_MM_PER_S_PER_PWM - Speed) / SIM_MOTOR_TAU_S;
+
+    if (Accel > Grip) {
+        Accel = Grip;
+    } else if (Accel < -Grip) {
+        Accel = -Grip;
+    }
+    return Speed + Accel * SIM_STEP_MS / 1000.0;
+}
+
+//heading in degrees after entering the pivot at Entry and stopping again
+static double SimPivot(int Entry, double Grip, unsigned int Accel, unsigned int Decel)
+{
+    double Left = Entry * SIM_MM_PER_S_PER_PWM, Right = Left;
+    double Theta = 0;
+    int32_t Actual[2] = {(int32_t) Entry * 1000, (int32_t) Entry * 1000};
+    int Target[2] = {1000, -1000};
+    int Command[2] = {Entry, Entry};
+    int t;
+
+    for (t = 0; t < SIM_TURN_MS + 1000; t += SIM_STEP_MS) {
+        if (t == SIM_TURN_MS) {
+            Target[0] = Target[1] = 0;
+        }
+        if ((t % SIM_TICK_MS) == 0) {
+            if (Accel == 0) {
+                Command[0] = Target[0];
+                Command[1] = Target[1];
+            } else {
+                Actual[0] = Drive_RampToward(Actual[0], Target[0], Accel, Decel, SIM_TICK_MS);
+                Actual[1] = Drive_RampToward(Actual[1], Target[1], Accel, Decel, SIM_TICK_MS);
+                Command[0] = Actual[0] / 1000;
+                Command[1] = Actual[1] / 1000;
+            }
+        }
+        Left = SimWheel(Left, Command[0], Grip);
+        Right = SimWheel(Right, Command[1], Grip);
+        Theta += (Left - Right) / SIM_WHEELBASE_MM * SIM_STEP_MS / 1000.0;
+    }
+    return Theta * 180.0 / M_PI;
+}
+
+int main(void)
+{
+    static const int Entries[] = {0, 1000, -1000};
+    static const char * const EntryNames[] = {"stopped", "forward", "reverse"};
+    static const unsigned int Ramps[][2] = {{0, 0}, {4000, 8000}, {2500, 4000}, {2000, 3000}};
+    double Heading, Sum, SumSquares, Min, Max, Grip;
+    unsigned int i, j, Run;
+
+    printf("%-10s %-9s %8s %8s %8s %8s\n", "ramp", "entry", "mean deg", "sd deg", "min", "max");
+    for (i = 0; i < sizeof (Ramps) / sizeof (Ramps[0]); i++) {
+        for (j = 0; j < sizeof (Entries) / sizeof (Entries[0]); j++) {
+            Sum = SumSquares = 0;
+            Min = 1e9;
+            Max = -1e9;
+            SimSeed = 118;
+            for (Run = 0; Run < SIM_RUNS; Run++) {
+                Grip = SIM_GRIP_MM_PER_S2 * (0.75 + 0.5 * SimRandom());
+                Heading = SimPivot(Entries[j], Grip, Ramps[i][0], Ramps[i][1]);
+                Sum += Heading;
+                SumSquares += Heading * Heading;
+                Min = (Heading < Min) ? Heading : Min;
+                Max = (Heading > Max) ? Heading : Max;
+            }
+            Sum /= SIM_RUNS;
+            if (Ramps[i][0] == 0) {
+                printf("%-10s", "none");
+            } else {
+                printf("%4u/%-5u", Ramps[i][0], Ramps[i][1]);
+            }
+            printf(" %-9s %8.1f %8.2f %8.1f %8.1f\n", EntryNames[j], Sum,
+                    sqrt(SumSquares / SIM_RUNS - Sum * Sum), Min, Max);
+        }
+    }
+    return 0;
+}
+#endif
 
 /* *****************************************************************************
  End of File
@@ -25,6 +25,17 @@
 /* ************************************************************************** */
 /* ************************************************************************** */
 
+//drive wheel ramp for Drive_SetRamp, PWM per second. THE RAMP IS DISABLED: both
+//are 0, so the wheels get their commands straight away as they always have.
+//Pivots entering from full reverse repeat to about 0.4 degrees over a 25 percent
+//change in grip in the MOTOR_RAMP_SIM model at 2500/4000, against 6.5 degrees with
+//no ramp. It stays off until the tick timed turns are re-measured with it on: at
+//2500/4000 a pivot from a stop comes up about 20 percent short (104 to 85 degrees),
+//which hits the TURN*_TICKS turns, the OPB turn back and the Aim_Beacon spin back.
+//Set both or neither, a single 0 is refused.
+#define DRIVE_ACCEL 0
+#define DRIVE_DECEL 0
+
 /**
  * @Function Motors_Init(void)
  * @param none
@@ -80,6 +91,79 @@ int LeftFlyWheelSpeed(int PWM);
  **/
 int RightWheelSpeed(int PWM);
 
+/**
+ * @Function Motors_SetThrottle(unsigned char Percent)
+ * @param Percent - 0 to 100, scales every later drive wheel command
+ * @return SUCCESS or ERROR
+ * @brief Cuts the drive current on a low battery, the flywheels are not throttled
+ **/
+char Motors_SetThrottle(unsigned char Percent);
+
+/**
+ * @Function Motors_GetLoad(void)
+ * @param none
+ * @return sum of the commanded |PWM| of all four motors, 0 to 4000
+ **/
+unsigned int Motors_GetLoad(void);
+
+/**
+ * @Function Drive_SetWheels(int Left, int Right)
+ * @param Left, Right - wheel commands from -1000 to 1000
+ * @return SUCCESS or ERROR
+ * @brief Sets both drive wheels together. Use instead of LeftWheelSpeed followed by
+ *        RightWheelSpeed, which leaves the wheels on mismatched commands in between
+ **/
+char Drive_SetWheels(int Left, int Right);
+
+/**
+ * @Function Drive_Set(int Speed, int Turn)
+ * @param Speed - forward command, -1000 to 1000
+ * @param Turn - difference between the wheels, positive turns left
+ * @return SUCCESS or ERROR
+ * @brief Left = Speed - Turn, Right = Speed + Turn. Speed gives way when a wheel
+ *        would saturate
+ **/
+char Drive_Set(int Speed, int Turn);
+
+/**
+ * @Function Motors_GetSkewTicks(void)
+ * @param none
+ * @return core timer ticks the last Drive_SetWheels spent writing the wheels, an
+ *         upper bound on the time their direction pins disagree
+ **/
+unsigned int Motors_GetSkewTicks(void);
+
+/**
+ * @Function Drive_SetRamp(unsigned int Accel, unsigned int Decel)
+ * @param Accel - PWM per second a drive wheel may speed up by
+ * @param Decel - PWM per second a drive wheel may slow down by
+ * @return SUCCESS, or ERROR if only one is zero
+ * @brief While ramping, Drive_SetWheels, Drive_Set, LeftWheelSpeed and
+ *        RightWheelSpeed only set targets, and Drive_RampTick moves the wheels toward
+ *        them. Both zero turns the ramp off, and that is how it ships (DRIVE_ACCEL and
+ *        DRIVE_DECEL). Only one zero is refused and leaves it off, as that wheel could
+ *        never change speed one way. The flywheels are never ramped.
+ **/
+char Drive_SetRamp(unsigned int Accel, unsigned int Decel);
+
+/**
+ * @Function Drive_RampTick(void)
+ * @param none
+ * @return None
+ * @brief Call from a periodic timer, every few ms. Steps by the time elapsed since
+ *        the last call, so the rates do not depend on the tick.
+ **/
+void Drive_RampTick(void);
+
+/**
+ * @Function Motors_GetWriteCounts(unsigned int *Issued, unsigned int *Elided)
+ * @param Issued - set to the motor commands written to the hardware
+ * @param Elided - set to the commands skipped as unchanged
+ * @return None
+ * @brief A command equal to the last one for that motor is not written again
+ **/
+void Motors_GetWriteCounts(unsigned int *Issued, unsigned int *Elided);
+
 #endif /* Motor_Driver_H */
 
 /* *****************************************************************************
@@ -34,7 +34,9 @@
 #include "OnePointerSubHSM.h"
 #include "Servo.h"
 #include "Motor_Driver.h"
+#include "Flywheel.h"
 #include "BCEventChecker.h"
+#include "Beacon.h"
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
  ******************************************************************************/
@@ -68,6 +70,8 @@ static first_run = 0;
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
 
+static void OPB_Shoot(void);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
@@ -76,6 +80,8 @@ static first_run = 0;
 
 static OnePointerSubHSMState_t CurrentState = Init; // <- change name to match ENUM
 static uint8_t MyPriority;
+static unsigned char Shot_Waiting = FALSE;   //the shot is due, held for FLYWHEEL_READY
+static uint16_t Release_Ticks;                 //gate held open this long once it gets there
 
 
 /*******************************************************************************
@@ -124,6 +130,9 @@ ES_Event RunOPBSubHSM(ES_Event ThisEvent)
     switch (CurrentState) {
         case Init: // If current state is initial Psedudo State
             CurrentState = Timeout;
+            Shot_Waiting = FALSE;
+            //a sweep left over from a shot that was cut short must not post into this one
+            Beacon_StopSweep();
             
             break;
 
@@ -139,30 +148,29 @@ ES_Event RunOPBSubHSM(ES_Event ThisEvent)
                         LeftWheelSpeed(300);
                         RightWheelSpeed(-300);
                     } 
+                    Beacon_StartSweep();
                     CurrentState = Find_Beacon;
                 }
             }
             break;
         case Find_Beacon:
-            if (ThisEvent.EventType == BEACON_PRESENT){
+            //the sweep has passed the beacon, turn back by the time since the peak
+            if (ThisEvent.EventType == BEACON_BEARING){
+                    Beacon_StopSweep();
                     CurrentState = Turn_To_Shoot;
-                    CurrentTime = ES_Timer_GetTime();
+                    CurrentTime = ES_Timer_GetTime() - ThisEvent.EventParam;
                     NewTime = (CurrentTime - LastTime);
-                    //NewTime = (NewTime/2) + ((TURN_CONSTANT*NewTime)/NewTime);
-                    ES_Timer_InitTimer(TURN_1PT_TIMER, NewTime);
+                    ES_Timer_InitTimer(TURN_1PT_TIMER, ThisEvent.EventParam ? ThisEvent.EventParam : 1);
 
                     if (Side == RIGHT){
-                        LeftWheelSpeed(0);
-                        RightWheelSpeed(0);
-                        LeftFlyWheelSpeed(-300);
-                        RightFlyWheelSpeed(-300);
+                        LeftWheelSpeed(300);
+                        RightWheelSpeed(-300);
                     } 
                     else if (Side == LEFT){
-                        LeftWheelSpeed(0);
-                        RightWheelSpeed(0);
-                        LeftFlyWheelSpeed(-300);
-                        RightFlyWheelSpeed(-300);
+                        LeftWheelSpeed(-300);
+                        RightWheelSpeed(300);
                     }
+                    Flywheel_SetSpeed(Params_Get(PARAM_FLYWHEEL_SPEED));
 
             }
             break;
@@ -172,42 +180,42 @@ ES_Event RunOPBSubHSM(ES_Event ThisEvent)
                 if (ThisEvent.EventParam == TURN_1PT_TIMER){
                     LeftWheelSpeed(0);
                     RightWheelSpeed(0);
-                    if (!first_run){
-                        ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS - 100);
-                        ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                        Send_Ball();
-                    }
-                    else {
-                        ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS);
-                        ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                        Send_Ball();
+                    //hold the shot for the flywheels, at most a spin-up from rest
+                    if (Shot_Waiting || Flywheel_MayShoot()) {
+                        OPB_Shoot();
+                    } else {
+                        Shot_Waiting = TRUE;
+                        ES_Timer_InitTimer(TURN_1PT_TIMER, FLYWHEEL_WAIT_TICKS);
                     }
                 } 
                 if (ThisEvent.EventParam == BALL_RELEASE_TIMER){
                     Stop_Ball();
                 }
                 if (ThisEvent.EventParam == SHOOT_TIMER){
-                    if (Side == LEFT) {
-                        ES_Timer_InitTimer(TURN_1PT_TIMER, NewTime); 
-                        CurrentState = Turn_Back;
-                        
-                    }
-                    else {
-                        ES_Timer_InitTimer(TURN_1PT_TIMER, NewTime);
-                        CurrentState = Turn_Back;
-                            if (Side == RIGHT){
-                            LeftWheelSpeed(300);
-                            RightWheelSpeed(-300);
-                            } 
-                            else if (Side == LEFT){
-                            LeftWheelSpeed(300);
-                            RightWheelSpeed(-300);
-                        }
+                    //undo the rotation from the start of the sweep to the beacon, against
+                    //the direction the sweep turned on either side
+                    ES_Timer_InitTimer(TURN_1PT_TIMER, NewTime ? NewTime : 1);
+                    CurrentState = Turn_Back;
+                    if (Side == RIGHT){
+                        LeftWheelSpeed(300);
+                        RightWheelSpeed(-300);
+                    } 
+                    else if (Side == LEFT){
+                        LeftWheelSpeed(-300);
+                        RightWheelSpeed(300);
                     }
                         
                 }
                 
             }
+            if ((ThisEvent.EventType == FLYWHEEL_READY) && Shot_Waiting) {
+                ES_Timer_StopTimer(TURN_1PT_TIMER);
+                OPB_Shoot();
+            }
+            //the gate is open, hold it there while the ball goes through
+            if ((ThisEvent.EventType == TURNSTILE_ARRIVED) && (ThisEvent.EventParam == TURNSTILE_SEND)) {
+                ES_Timer_InitTimer(BALL_RELEASE_TIMER, Release_Ticks);
+            }
             break;
         case Turn_Back:
 //            if (Side == RIGHT){
@@ -239,3 +247,25 @@ ES_Event RunOPBSubHSM(ES_Event ThisEvent)
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/**
+ * @Function OPB_Shoot(void)
+ * @return None
+ * @brief Releases the ball and starts the timer that ends the shot. The gate closes
+ *        Release_Ticks after TURNSTILE_ARRIVED says it is open. */
+static void OPB_Shoot(void)
+{
+    int Ticks;
+
+    Shot_Waiting = FALSE;
+    if (!first_run){
+        Ticks = BALL_RELEASE_TICKS - 100 - TURNSTILE_MOVE_MS;
+    }
+    else {
+        Ticks = BALL_RELEASE_TICKS - TURNSTILE_MOVE_MS;
+    }
+    //a small or negative BALL_RELEASE_TICKS still closes the gate
+    Release_Ticks = (Ticks > 0) ? Ticks : 1;
+    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
+    Send_Ball();
+    Flywheel_Shot();
+}
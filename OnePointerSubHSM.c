@@ -34,15 +34,16 @@
 #include "OnePointerSubHSM.h"
 #include "Servo.h"
 #include "Motor_Driver.h"
+#include "Flywheel.h"
 #include "BCEventChecker.h"
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
  ******************************************************************************/
 
 #define TURN_1PT_TIMER 2
-#define TURNL_1PT_TICKS 100
-#define TURNR_1PT_TICKS 15
-#define FSpeed_TICKS 1200
+#define TURNL_1PT_TICKS Params_Get(PARAM_TURNL_1PT_TICKS)
+#define TURNR_1PT_TICKS Params_Get(PARAM_TURNR_1PT_TICKS)
+#define FSpeed_TICKS Params_Get(PARAM_FSPEED_1PT_TICKS)
 
 
 typedef enum {
@@ -62,13 +63,14 @@ static const char *StateNames[] = {
 
 //extern unsigned char Side;
 //static unsigned char Side;
-static first_run = 0;
 /*******************************************************************************
  * PRIVATE FUNCTION PROTOTYPES                                                 *
  ******************************************************************************/
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
 
+static void OnePointer_Shoot(void);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
@@ -78,6 +80,8 @@ static first_run = 0;
 static OnePointerSubHSMState_t CurrentState = Init; // <- change name to match ENUM
 static uint8_t MyPriority;
 static int Shot_Twice = 0;
+static unsigned char Shot_Waiting = FALSE;   //a shot is due, held for FLYWHEEL_READY
+static uint16_t Release_Ticks;                 //gate held open this long once it gets there
 
 
 /*******************************************************************************
@@ -122,6 +126,7 @@ ES_Event RunOnePointerSubHSM(ES_Event ThisEvent)
     switch (CurrentState) {
         case Init: // If current state is initial Psedudo State
             CurrentState = Turn;
+            Shot_Waiting = FALSE;
             break;
 
         case Turn: // in the first state, replace this with correct names
@@ -146,25 +151,16 @@ ES_Event RunOnePointerSubHSM(ES_Event ThisEvent)
                 if ((ThisEvent.EventParam == TURN_1PT_TIMER) && !Shot_Twice){
                     LeftWheelSpeed(0);
                     RightWheelSpeed(0);
-                    Shot_Twice++;
-                    if (!first_run){
-                        ES_Timer_InitTimer(TURN_1PT_TIMER, FSpeed_TICKS);
-                        ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS - 200);
-                        ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                        Send_Ball();
-                    }
-                    else {
-                        ES_Timer_InitTimer(TURN_1PT_TIMER, FSpeed_TICKS);
-                        ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS - 200);
-                        ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                        Send_Ball();
+                    //hold the shot for the flywheels, at most a spin-up from rest
+                    if (Shot_Waiting || Flywheel_MayShoot()) {
+                        OnePointer_Shoot();
+                    } else {
+                        Shot_Waiting = TRUE;
+                        ES_Timer_InitTimer(TURN_1PT_TIMER, FLYWHEEL_WAIT_TICKS);
                     }
                 } 
-                else if ((ThisEvent.EventParam == TURN_1PT_TIMER) && Shot_Twice) {
-                    Shot_Twice++;
-                    ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS - 100);
-                    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                    Send_Ball();
+                else if ((ThisEvent.EventParam == TURN_1PT_TIMER) && (Shot_Twice == 1)) {
+                    OnePointer_Shoot();
                 }
                 
                 if (ThisEvent.EventParam == BALL_RELEASE_TIMER){
@@ -185,6 +181,22 @@ ES_Event RunOnePointerSubHSM(ES_Event ThisEvent)
                 }
                 
             }
+            if ((ThisEvent.EventType == FLYWHEEL_READY) && Shot_Waiting) {
+                OnePointer_Shoot();
+            }
+            if (ThisEvent.EventType == TURNSTILE_ARRIVED) {
+                if (ThisEvent.EventParam == TURNSTILE_SEND) {
+                    //the gate is open, hold it there while the ball goes through
+                    ES_Timer_InitTimer(BALL_RELEASE_TIMER, Release_Ticks);
+                } else if ((Shot_Twice == 1) && FLYWHEEL_GATES_SHOTS) {
+                    //the gate is closed, the second shot only waits for the flywheels to recover
+                    if (Flywheel_IsReady()) {
+                        OnePointer_Shoot();
+                    } else {
+                        Shot_Waiting = TRUE;
+                    }
+                }
+            }
             break;
         case Turn_Back:
             if (Side == RIGHT){
@@ -217,3 +229,29 @@ ES_Event RunOnePointerSubHSM(ES_Event ThisEvent)
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/**
+ * @Function OnePointer_Shoot(void)
+ * @return None
+ * @brief Fires the next of the two balls. After the first, TURN_1PT_TIMER is left
+ *        running for the second, or with FLYWHEEL_GATES_SHOTS as the latest it goes
+ *        if the flywheels never report ready again. The gate closes Release_Ticks after TURNSTILE_ARRIVED says
+ *        it is open. */
+static void OnePointer_Shoot(void)
+{
+    int Ticks;
+
+    Shot_Waiting = FALSE;
+    Shot_Twice++;
+    if (Shot_Twice == 1) {
+        ES_Timer_InitTimer(TURN_1PT_TIMER, FSpeed_TICKS);
+        Ticks = BALL_RELEASE_TICKS - 200 - TURNSTILE_MOVE_MS;
+    } else {
+        ES_Timer_StopTimer(TURN_1PT_TIMER);
+        Ticks = BALL_RELEASE_TICKS - 100 - TURNSTILE_MOVE_MS;
+    }
+    //BALL_RELEASE_TICKS is set over serial, a small one must not wrap to a minute
+    Release_Ticks = (Ticks > 0) ? Ticks : 1;
+    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
+    Send_Ball();
+    Flywheel_Shot();
+}
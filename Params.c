@@ -0,0 +1,293 @@
+#include "BOARD.h"
+#include "serial.h"
+#include "Params.h"
+#include "AD.h"
+#include "Motor_Driver.h"
+#include "AnalogTapeSensors.h"
+#include "WallEstimator.h"
+
+#include <xc.h>
+#include <sys/kmem.h>
+#include <stdio.h>
+
+/*
+ * Each record is two words: the parameter Id in the upper half and the value in the
+ * lower half of the first, and its complement in the second. Words are programmed one
+ * at a time, so a record torn by a reset fails the complement check and is skipped.
+ * Later records win when the page is replayed at boot. When the page fills it is
+ * erased and the values that were set are written back, so the page is erased once
+ * every PARAM_RECORDS changes.
+ */
+#define PARAM_PAGE_ADDRESS 0xBD01F000   //kseg1, reads bypass the prefetch cache
+#define PARAM_PAGE_SIZE 4096
+#define PARAM_RECORDS (PARAM_PAGE_SIZE / 8)
+#define ERASED_WORD 0xFFFFFFFF
+
+#define NVMOP_WORD_PROGRAM 0x1
+#define NVMOP_PAGE_ERASE 0x4
+#define NVM_LVD_STARTUP_US 7
+
+#define COMMAND_LENGTH 24
+
+//the tape thresholds default to 0, AnalogTapeSensors falls back to its own table
+static const int16_t DefaultParams[NUM_PARAMS] = {
+    100,    //PARAM_TURNL_1PT_TICKS
+    15,     //PARAM_TURNR_1PT_TICKS
+    1200,   //PARAM_FSPEED_1PT_TICKS
+    50,     //PARAM_TURNL_2PT_TICKS
+    50,     //PARAM_TURNR_2PT_TICKS
+    200,    //PARAM_TURN_3PT_TICKS
+    400,    //PARAM_BALL_RELEASE_TICKS
+    1000,   //PARAM_SHOOT_TICKS
+    -300,   //PARAM_FLYWHEEL_SPEED
+    [PARAM_WALL_KP] = 96,
+    [PARAM_WALL_KI] = 1,
+    [PARAM_WALL_KD] = 48,
+    [PARAM_WALL_DISTANCE] = 100,
+    [PARAM_WALL_SPEED] = 800,
+    [PARAM_BATTERY_SAG] = 4,
+    //nominal wall distances at TAPE_CONTACT to TAPE_FAR, not measured yet
+    [PARAM_WALL_LEVEL_MM + TAPE_CONTACT] = 25,
+    [PARAM_WALL_LEVEL_MM + TAPE_INRANGE] = 50,
+    [PARAM_WALL_LEVEL_MM + TAPE_CLOSE] = 75,
+    [PARAM_WALL_LEVEL_MM + TAPE_FAR] = 150,
+};
+
+static int16_t Params[NUM_PARAMS];
+static uint64_t ParamsSet;          //bit per Id, value came from flash
+
+//ParamsSet has a bit per Id, a table that outgrows it fails to compile here
+typedef char ParamsFitMask[(NUM_PARAMS <= 64) ? 1 : -1];
+static unsigned int NextRecord;
+
+static char Params_NVMOperation(unsigned int Operation);
+static char Params_WriteWord(unsigned int Offset, uint32_t Data);
+static char Params_Append(unsigned char Id, int16_t Value);
+static char Params_Compact(void);
+
+char Params_Init(void){
+    const volatile uint32_t *Page = (const volatile uint32_t *) PARAM_PAGE_ADDRESS;
+    uint32_t Record;
+    unsigned int Valid = 0;
+    unsigned int Torn = 0;
+    unsigned char Id;
+
+    for (Id = 0; Id < NUM_PARAMS; Id++) {
+        Params[Id] = DefaultParams[Id];
+    }
+    ParamsSet = 0;
+    for (NextRecord = 0; NextRecord < PARAM_RECORDS; NextRecord++) {
+        Record = Page[NextRecord * 2];
+        if ((Record == ERASED_WORD) && (Page[NextRecord * 2 + 1] == ERASED_WORD)) {
+            break;
+        }
+        Id = Record >> 16;
+        if ((Page[NextRecord * 2 + 1] == ~Record) && (Id < NUM_PARAMS)) {
+            Params[Id] = (int16_t) (Record & 0xFFFF);
+            ParamsSet |= ((uint64_t) 1 << Id);
+            Valid++;
+        } else {
+            Torn++;
+        }
+    }
+    //nothing but garbage, the page was never ours
+    if ((Valid == 0) && (Torn != 0)) {
+        Params_Compact();
+        return ERROR;
+    }
+    return SUCCESS;
+}
+
+int16_t Params_Get(unsigned char Id){
+    if (Id >= NUM_PARAMS) {
+        return 0;
+    }
+    return Params[Id];
+}
+
+unsigned char Params_IsSet(unsigned char Id){
+    if (Id >= NUM_PARAMS) {
+        return FALSE;
+    }
+    return (ParamsSet & ((uint64_t) 1 << Id)) != 0;
+}
+
+char Params_Set(unsigned char Id, int16_t Value){
+    if (Id >= NUM_PARAMS) {
+        return ERROR;
+    }
+    if (Params_IsSet(Id) && (Params[Id] == Value)) {
+        return SUCCESS;
+    }
+    Params[Id] = Value;
+    ParamsSet |= ((uint64_t) 1 << Id);
+    if (NextRecord >= PARAM_RECORDS) {
+        //the values are already in RAM, so compacting writes the new one as well
+        return Params_Compact();
+    }
+    return Params_Append(Id, Value);
+}
+
+void Params_CheckSerial(unsigned char Stopped){
+    static char Line[COMMAND_LENGTH];
+    static unsigned char Length = 0;
+    unsigned int Id;
+    unsigned int Issued, Elided;
+    int Value;
+    char ch;
+
+    while (!IsReceiveEmpty()) {
+        ch = GetChar();
+        if ((ch != '\r') && (ch != '\n')) {
+            if (Length < (COMMAND_LENGTH - 1)) {
+                Line[Length++] = ch;
+            }
+            continue;
+        }
+        Line[Length] = '\0';
+        if (Line[0] == 'p') {
+            if (sscanf(&Line[1], "%u %d", &Id, &Value) == 2) {
+                if ((Id >= NUM_PARAMS) || (Value < INT16_MIN) || (Value > INT16_MAX)) {
+                    printf("param %u value %d out of range\r\n", Id, Value);
+                } else if (!Stopped) {
+                    //a page erase would stall the match tick for up to 20ms
+                    printf("param %u not stored, tuning needs a bumper held at power up\r\n", Id);
+                } else if (Params_Set(Id, Value) == ERROR) {
+                    printf("param %u not stored\r\n", Id);
+                }
+            } else {
+                for (Id = 0; Id < NUM_PARAMS; Id++) {
+                    printf("p %2u %6d%s\r\n", Id, Params[Id], Params_IsSet(Id) ? "" : " (default)");
+                    while (!IsTransmitEmpty());
+                }
+            }
+        } else if (Line[0] == 'a') {
+            if (sscanf(&Line[1], "%d", &Value) == 1) {
+                //the modulated tape sensors switch the emitters once per scan
+                if (Value && Analog_TapeIsModulated()) {
+                    printf("batching stays off while the tape sensors are modulated\r\n");
+                } else {
+                    AD_SetBatching(Value);
+                }
+            }
+            AD_PrintDiagnostics();
+        } else if (Line[0] == 'm') {
+            Motors_GetWriteCounts(&Issued, &Elided);
+            printf("motor writes %u issued, %u elided\r\n", Issued, Elided);
+        } else if (Line[0] == 'w') {
+            WallEstimator_PrintDiagnostics();
+        }
+        Length = 0;
+    }
+}
+
+/**
+ * @function Params_NVMOperation(unsigned int Operation)
+ * @param Operation - NVMOP_x
+ * @return SUCCESS or ERROR
+ * @brief Runs the unlock sequence and waits for the flash controller. Interrupts are
+ *        only held off for the unlock, the CPU stalls on flash fetches anyway. */
+static char Params_NVMOperation(unsigned int Operation){
+    unsigned int Interrupts;
+    uint32_t Start;
+
+    NVMCON = _NVMCON_WREN_MASK | Operation;
+    Start = _CP0_GET_COUNT();
+    while ((_CP0_GET_COUNT() - Start) < (NVM_LVD_STARTUP_US * CORE_TICKS_PER_US));
+    Interrupts = __builtin_disable_interrupts();
+    NVMKEY = 0xAA996655;
+    NVMKEY = 0x556699AA;
+    NVMCONSET = _NVMCON_WR_MASK;
+    if (Interrupts & 0x1) {
+        __builtin_enable_interrupts();
+    }
+    while (NVMCON & _NVMCON_WR_MASK);
+    NVMCONCLR = _NVMCON_WREN_MASK;
+    return (NVMCON & (_NVMCON_WRERR_MASK | _NVMCON_LVDERR_MASK)) ? ERROR : SUCCESS;
+}
+
+static char Params_WriteWord(unsigned int Offset, uint32_t Data){
+    NVMADDR = KVA_TO_PA(PARAM_PAGE_ADDRESS + Offset);
+    NVMDATA = Data;
+    return Params_NVMOperation(NVMOP_WORD_PROGRAM);
+}
+
+static char Params_Append(unsigned char Id, int16_t Value){
+    uint32_t Record = ((uint32_t) Id << 16) | (uint16_t) Value;
+    unsigned int Offset = NextRecord * 8;
+
+    //the slot is used up even if the write fails, a torn record is skipped on replay
+    NextRecord++;
+    if (Params_WriteWord(Offset, Record) == ERROR) {
+        return ERROR;
+    }
+    return Params_WriteWord(Offset + 4, ~Record);
+}
+
+/**
+ * @function Params_Compact(void)
+ * @return SUCCESS or ERROR
+ * @brief Erases the page and writes back one record per parameter that was set.
+ * @note A reset during the erase loses the stored values, they fall back to the
+ *       defaults and the tape thresholds are recalibrated at the next boot */
+static char Params_Compact(void){
+    unsigned char Id;
+
+    NVMADDR = KVA_TO_PA(PARAM_PAGE_ADDRESS);
+    if (Params_NVMOperation(NVMOP_PAGE_ERASE) == ERROR) {
+        return ERROR;
+    }
+    NextRecord = 0;
+    for (Id = 0; Id < NUM_PARAMS; Id++) {
+        if (Params_IsSet(Id) && (Params_Append(Id, Params[Id]) == ERROR)) {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+//#define PARAMS_TEST
+#ifdef PARAMS_TEST
+/*
+ * Writes enough records to wrap the page twice, then reloads the page the way a reboot
+ * would and checks that the replayed values match what was written. This leaves test
+ * values in the store, clear them with "p <id> <value>" before running the robot.
+ */
+int main(void){
+    int16_t Expected[NUM_PARAMS];
+    unsigned int i;
+    unsigned int Errors = 0;
+    unsigned char Id;
+    uint32_t Start;
+
+    BOARD_Init();
+    printf("\r\nParams flash store test harness, %d records per page\r\n", PARAM_RECORDS);
+    Params_Init();
+    for (Id = 0; Id < NUM_PARAMS; Id++) {
+        Expected[Id] = Params_Get(Id);
+    }
+    Start = _CP0_GET_COUNT();
+    for (i = 0; i < (PARAM_RECORDS * 2 + 7); i++) {
+        Id = i % NUM_PARAMS;
+        Expected[Id] = (int16_t) (i * 37 - 5000);
+        if (Params_Set(Id, Expected[Id]) == ERROR) {
+            printf("write %u failed\r\n", i);
+            Errors++;
+        }
+    }
+    printf("%u writes in %lu ms\r\n", i, (_CP0_GET_COUNT() - Start) / CORE_TICKS_PER_MS);
+    Params_Init();
+    printf("%u records in use after reload\r\n", NextRecord);
+    for (Id = 0; Id < NUM_PARAMS; Id++) {
+        if ((Params_Get(Id) != Expected[Id]) || !Params_IsSet(Id)) {
+            printf("param %u read %d expected %d\r\n", Id, Params_Get(Id), Expected[Id]);
+            Errors++;
+        }
+    }
+    printf("%u errors\r\n", Errors);
+    while (1) {
+        Params_CheckSerial(TRUE);
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,81 @@
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#ifndef Params_H
+#define Params_H
+
+#include "BOARD.h"
+
+#include <xc.h>
+#include <stdio.h>
+
+/*
+ * Tuning parameters kept in the last page of flash (0x9D01F000, left out of
+ * kseg0_program_mem in bootloader320.ld). Each change is appended as a record, so the
+ * page is only erased once it fills. Params_Get reads a RAM copy and is O(1).
+ */
+#define PARAM_TURNL_1PT_TICKS 0
+#define PARAM_TURNR_1PT_TICKS 1
+#define PARAM_FSPEED_1PT_TICKS 2
+#define PARAM_TURNL_2PT_TICKS 3
+#define PARAM_TURNR_2PT_TICKS 4
+#define PARAM_TURN_3PT_TICKS 5
+#define PARAM_BALL_RELEASE_TICKS 6
+#define PARAM_SHOOT_TICKS 7
+#define PARAM_FLYWHEEL_SPEED 8
+#define PARAM_TAPE_THRESHOLD 9      //one per sensor and level, see Analog_TapeGetThreshold
+#define PARAM_WALL_KP 25            //WallController gains are in 1/16ths
+#define PARAM_WALL_KI 26
+#define PARAM_WALL_KD 27
+#define PARAM_WALL_DISTANCE 28      //mm
+#define PARAM_WALL_SPEED 29         //PWM
+#define PARAM_BATTERY_SAG 30        //A/D counts of sag per 1000 PWM of motor load
+#define PARAM_WALL_LEVEL_MM 31      //mm, one per tape level, see WallEstimator.c
+#define NUM_PARAMS 35               //at most 64, ParamsSet is a bit mask
+
+/**
+ * @function Params_Init(void)
+ * @return SUCCESS, or ERROR if the page was unreadable and had to be erased
+ * @brief Loads the defaults and then replays the records in the flash page over them */
+char Params_Init(void);
+
+/**
+ * @function Params_Get(unsigned char Id)
+ * @param Id - PARAM_x
+ * @return current value, 0 for a bad Id */
+int16_t Params_Get(unsigned char Id);
+
+/**
+ * @function Params_IsSet(unsigned char Id)
+ * @param Id - PARAM_x
+ * @return TRUE if the value came from flash rather than the defaults */
+unsigned char Params_IsSet(unsigned char Id);
+
+/**
+ * @function Params_Set(unsigned char Id, int16_t Value)
+ * @param Id - PARAM_x
+ * @param Value - new value
+ * @return SUCCESS or ERROR
+ * @brief Updates the RAM copy and appends a record to flash. Nothing is written if
+ *        the value is unchanged.
+ * @note Flash writes stall the CPU (about 20us per word, 20ms for the erase when the
+ *       page is full), so only call this while stopped, not from a running match */
+char Params_Set(unsigned char Id, int16_t Value);
+
+/**
+ * @function Params_CheckSerial(unsigned char Stopped)
+ * @param Stopped - TRUE if the robot is stopped and flash may be written, BdayFSM
+ *        passes TRUE in Tune (bumper held at power up) and Test_Stop
+ * @return None
+ * @brief Non blocking serial command line for tuning: "p" lists every parameter,
+ *        "p <id> <value>" sets and stores one, but only while Stopped. "a" prints the
+ *        A/D interrupt load and "a 1" or "a 0" turns A/D batching on or off, it
+ *        stays off while Analog_TapeIsModulated. "m" prints how many motor writes
+ *        were issued and how many were skipped as unchanged. "w" prints the wall
+ *        sensors against their thresholds. Call it from a periodic timer. */
+void Params_CheckSerial(unsigned char Stopped);
+
+#endif /* Params_H */
@@ -61,7 +61,7 @@
 #define RCPINCOUNT      10
 #define SERVOCENTER     1500
 #define RCPERIODTIME    (RCPINCOUNT * MAXPULSE)
-#define FULLOVERFLOW    0xFFFF
+#define MINEDGEGAP      8   // uSec, closer pulse ends are lowered together
 
 #define RC_TRISX03  TRISFbits.TRISF5
 #define RC_LATX03   LATFbits.LATF5
@@ -88,14 +88,24 @@
 #define RC_TRISW08  TRISBbits.TRISB14
 #define RC_LATW08   LATBbits.LATB14
 
+// the LAT register each pin is on, the schedule keeps one mask per register
+#define RC_LATB     0
+#define RC_LATD     1
+#define RC_LATE     2
+#define RC_LATF     3
+#define RC_NUMLATS  4
+
 /* Note that you need to set the prescalar and periferal clock appropriate to
- * the processor board that you are using. In order to calculate the minimal
- * prescalar: Prescalar = (2000*F_PB/(1000000*0xFFFF))+1, round down */
+ * the processor board that you are using. The whole idle time of the frame has
+ * to fit in one period, so the minimal prescalar is:
+ * Prescalar = (RCPERIODTIME*F_PB/(1000000*0xFFFF))+1, round up to one TIMER4 has */
 
 #define F_PB        (BOARD_GetPBClock())
 #define F_PB_IN_KHZ (F_PB/1000)
-#define PRESCALE    2
-#define uSEC        (F_PB_IN_KHZ / (PRESCALE * 1000))
+#define PRESCALE    16
+#define TIMER4_TCKPS 0b100  // 1:16
+#define COUNTS_PER_MS (F_PB_IN_KHZ / PRESCALE)
+#define RC_Counts(uSec) (((unsigned int) (uSec) * COUNTS_PER_MS) / 1000)
 #define ALLRCPINS   0x3FF
 
 /* Code readability Macros, information hiding */
@@ -104,8 +114,6 @@
 
 #define RC_SetPin(pin)      *RC_LATSET[pin] = rcBitsMap[pin]
 #define RC_ClearPin(pin)    *RC_LATCLR[pin] = rcBitsMap[pin]
-#define RC_SetPeriod(pin)   WritePeriod4(ReadTimer4() + uSEC * RCupTime[pin])
-#define RC_GetTime(pin)     RCupTime[pin]
 
 /*******************************************************************************
  * PRIVATE VARIABLES                                                           *
@@ -130,20 +138,43 @@ static volatile unsigned int * const RC_LATCLR[] = {&LATFCLR, &LATBCLR, &LATDCLR
     &LATBCLR};
 static unsigned short int rcBitsMap[] = {BIT_5, BIT_0, BIT_10, BIT_7, BIT_8,
     BIT_1, BIT_2, BIT_3, BIT_15, BIT_14};
+static const unsigned char rcLatMap[] = {RC_LATF, RC_LATB, RC_LATD, RC_LATE, RC_LATD,
+    RC_LATE, RC_LATB, RC_LATB, RC_LATB, RC_LATB};
 
 unsigned char RCenabled = FALSE;
 
-static enum {
-    none, pulsing, idling
-} RCstate = none;
+/* One frame of edges, in time order. The first slot raises every active pin at the
+ * start of the frame, each later one lowers the pins whose pulses end there. Period
+ * is the PR4 value that times the gap to the next slot, the last one runs to the end
+ * of the frame. */
+typedef struct {
+    unsigned short int Lat[RC_NUMLATS];
+    unsigned short int Period;
+} RCslot;
+
+static RCslot Schedule[RCPINCOUNT + 1];
+static unsigned char numSlots = 1;
+static unsigned char slotIndex = 0;
+static volatile unsigned char scheduleStale = FALSE;
 
 static short int RCupTime[RCPINCOUNT];
 static short int RCpinsActive = 0x0000;
-static char numRCPins = 0;
-static int uSecondsLeftToGo = RCPERIODTIME;
+
+// pulse times ramping under RC_MovePulseTime, one step per frame
+static short int moveStart[RCPINCOUNT];
+static short int moveTarget[RCPINCOUNT];
+static unsigned short int moveFrames[RCPINCOUNT];
+static unsigned short int moveFrame[RCPINCOUNT];
+static volatile unsigned short int pinsMoving = 0x0000;
 static volatile unsigned short int pinsToAdd = 0x0000;
 static volatile unsigned short int pinsToRemove = 0x0000;
 
+#ifdef RC_SERVO_TEST
+// interrupts and core timer ticks spent in them, over the last whole frame
+static unsigned short int frameInterrupts, countInterrupts;
+static unsigned int frameTicks, countTicks;
+#endif
+
 /*******************************************************************************
  * PRIVATE FUNCTIONS PROTOTYPES                                                *
  ******************************************************************************/
@@ -151,6 +182,8 @@ static volatile unsigned short int pinsToRemove = 0x0000;
 void RC_InstallPins(void);
 void RC_DeletePins(void);
 void RC_ShutDown(void);
+void RC_BuildSchedule(void);
+void RC_StepMoves(void);
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -176,10 +209,15 @@ char RC_Init(void)
         RCupTime[i] = 0;
     }
 
+    RCpinsActive = 0x0000;
+    pinsMoving = 0x0000;
+    RC_BuildSchedule(); // empty frame until pins are added
+    slotIndex = 0;
+
     T4CON = 0; //start with nothing set in register
-    T4CONbits.TCKPS = 0b001; // set prescaler to 1:2
+    T4CONbits.TCKPS = TIMER4_TCKPS; // set prescaler to 1:16
     TMR4 = 0; // start the timer at 0
-    PR4 = SERVOCENTER*uSEC; //and sent its default period
+    PR4 = RC_Counts(SERVOCENTER); //and sent its default period
     T4CONbits.ON = 1; //turn timer on
 
     IFS0bits.T4IF = 0; // clear remnant flag
@@ -189,7 +227,6 @@ char RC_Init(void)
     // Module is initialized
     dbprintf("\nRC_Servo: module initialized");
     RCenabled = TRUE;
-    RCstate = none;
     return SUCCESS;
 }
 
@@ -276,11 +313,13 @@ unsigned short int RC_ListPins(void)
  * @brief Sets the up time of the corresponding RC_PORTxxx pin to the value
  *        in pulseTime in uSec [1000 to 2000 nominally]. Checks for valid
  *        inputs for RCpin and ranges for pulseTime. Returns ERROR if the
- *        pin is not currently active.
+ *        pin is not currently active. The new time is used from the next
+ *        frame on.
  * @author Gabriel Hugh Elkaim, 2011.12.15 16:42 */
 char RC_SetPulseTime(unsigned short int RCpin, unsigned short int pulseTime)
 {
     char i;
+    unsigned short int pinMask = RCpin;
     if ((pulseTime < MINPULSE) || (pulseTime > MAXPULSE)) {
         // error state, input out of range
         dbprintf("\nRC_Servo: Set Pulse FAILED, pulse time out of range");
@@ -299,7 +338,15 @@ char RC_SetPulseTime(unsigned short int RCpin, unsigned short int pulseTime)
             i++;
         }
         dbprintf("\nRC_Servo: Set Pulse for pin %d at %d uSec", i, pulseTime);
-        RCupTime[i] = pulseTime;
+        if (pinsMoving & pinMask) { // a new time stops the pin where it is moving
+            IEC0bits.T4IE = 0;
+            pinsMoving &= ~pinMask;
+            IEC0bits.T4IE = 1;
+        }
+        if (RCupTime[i] != pulseTime) {
+            RCupTime[i] = pulseTime;
+            scheduleStale = TRUE; // picked up at the end of the current frame
+        }
         return SUCCESS;
     }
     // error state, pin not active
@@ -307,6 +354,64 @@ char RC_SetPulseTime(unsigned short int RCpin, unsigned short int pulseTime)
     return ERROR;
 }
 
+/**
+ * @Function RC_MovePulseTime(unsigned short int RCpin, unsigned short int pulseTime,
+ *           unsigned short int moveTime)
+ * @param RCpin - use #defined RC_PORTxxx (only one)
+ * @param pulseTime - pulse width in uSeconds from [1000 to 2000] to end up at
+ * @param moveTime - mSec to get there in
+ * @return SUCCESS or ERROR
+ * @brief Ramps the pulse width from where it is now to pulseTime, one step at
+ *        the end of each frame, so the servo follows at a set speed instead of
+ *        slewing as fast as it can. RC_IsMoving stays TRUE until the frame with
+ *        pulseTime has gone out. A moveTime under one frame is a single step.
+ *        Same errors as RC_SetPulseTime. */
+char RC_MovePulseTime(unsigned short int RCpin, unsigned short int pulseTime, unsigned short int moveTime)
+{
+    char i;
+    unsigned short int pinMask = RCpin;
+
+    if ((pulseTime < MINPULSE) || (pulseTime > MAXPULSE)) {
+        dbprintf("\nRC_Servo: Move Pulse FAILED, pulse time out of range");
+        return ERROR;
+    }
+    if ((RCpin == 0x000) || (RCpin > ALLRCPINS) || (!RCenabled)) {
+        dbprintf("\nRC_Servo: Move Pulse FAILED, out of bounds or module inactive");
+        return ERROR;
+    }
+    if (!((RCpin & RCpinsActive) || (RCpin & pinsToAdd))) {
+        dbprintf("\nRC_Servo: Move Pulse FAILED, pin inactive");
+        return ERROR;
+    }
+    i = 0;
+    while (RCpin > 1) { // find position of 1 in RCpin
+        RCpin >>= 1;
+        i++;
+    }
+    // the frame update steps the move, keep it out while this one is set up
+    IEC0bits.T4IE = 0;
+    moveStart[i] = (RCupTime[i] != 0) ? RCupTime[i] : SERVOCENTER;
+    moveTarget[i] = pulseTime;
+    moveFrames[i] = ((unsigned int) moveTime * 1000 + RCPERIODTIME - 1) / RCPERIODTIME;
+    if (moveFrames[i] == 0) {
+        moveFrames[i] = 1;
+    }
+    moveFrame[i] = 0;
+    pinsMoving |= pinMask;
+    IEC0bits.T4IE = 1;
+    dbprintf("\nRC_Servo: Move Pulse for pin %d to %d uSec in %d frames", i, pulseTime, moveFrames[i]);
+    return SUCCESS;
+}
+
+/**
+ * @Function RC_IsMoving(unsigned short int RCpins)
+ * @param RCpins - use #defined RC_PORTxxx OR'd together
+ * @return TRUE if any of the pins is still moving under RC_MovePulseTime */
+char RC_IsMoving(unsigned short int RCpins)
+{
+    return (pinsMoving & RCpins) ? TRUE : FALSE;
+}
+
 /**
  * @Function RcGetPulseTime(unsigned short int RCpin)
  * @param RCpin - use #defined RC_PORTxxx (only one)
@@ -398,7 +503,6 @@ void RC_InstallPins(void)
         for (i = 0; i < RCPINCOUNT; i++) {
             curPin = (1 << i);
             if (pinsToAdd & curPin) {
-                numRCPins++;
                 if (RCupTime[i] == 0) {
                     RCupTime[i] = SERVOCENTER;
                 }
@@ -409,6 +513,7 @@ void RC_InstallPins(void)
         }
         RCpinsActive |= pinsToAdd;
         pinsToAdd = 0x000;
+        scheduleStale = TRUE;
     }
 }
 
@@ -428,7 +533,6 @@ void RC_DeletePins(void)
         for (i = 0; i < RCPINCOUNT; i++) {
             curPin = (1 << i);
             if (pinsToRemove & curPin) {
-                numRCPins--;
                 RC_ClearPin(i); // Forces pin to low state
                 RC_SetInput(i); // Set pin as input
                 dbprintf("\nRemoving pin: 0x%X", curPin);
@@ -436,6 +540,7 @@ void RC_DeletePins(void)
         }
         RCpinsActive &= ~pinsToRemove;
         pinsToRemove = 0;
+        scheduleStale = TRUE;
     }
 }
 
@@ -454,14 +559,97 @@ void RC_ShutDown(void)
         pinsToRemove = RCpinsActive;
         RC_DeletePins();
     }
-    numRCPins = 0;
     for (i = 0; i < RCPINCOUNT; i++) {
         RCupTime[i] = 0;
     }
+    pinsMoving = 0x0000;
     IEC0bits.T4IE = 0;
 }
 
 
+/**
+ * @Function RC_BuildSchedule(void) -- PRIVATE FUNCTION
+ * @param none
+ * @return none
+ * @brief Sorts the pulse ends of the active pins and lays out the slots of a
+ *        frame from them. Pins ending at the same time, or within MINEDGEGAP of
+ *        the slot before, share that slot, so no two interrupts come closer
+ *        than the ISR can keep up with.
+ * @note Called from the last slot of a frame, when every pin is low and the
+ *       next interrupt is the whole idle time away. */
+void RC_BuildSchedule(void)
+{
+    unsigned short int endCounts[RCPINCOUNT];
+    char endPin[RCPINCOUNT];
+    char numEnds = 0;
+    unsigned short int slotTime[RCPINCOUNT + 1];
+    unsigned short int counts;
+    char i, j, lat;
+
+    scheduleStale = FALSE;
+    for (lat = 0; lat < RC_NUMLATS; lat++) {
+        Schedule[0].Lat[lat] = 0;
+    }
+    // insertion sort of the pulse ends, slot 0 raises them all
+    for (i = 0; i < RCPINCOUNT; i++) {
+        if (RCpinsActive & (1 << i)) {
+            Schedule[0].Lat[rcLatMap[i]] |= rcBitsMap[i];
+            counts = RC_Counts(RCupTime[i]);
+            for (j = numEnds; (j > 0) && (endCounts[j - 1] > counts); j--) {
+                endCounts[j] = endCounts[j - 1];
+                endPin[j] = endPin[j - 1];
+            }
+            endCounts[j] = counts;
+            endPin[j] = i;
+            numEnds++;
+        }
+    }
+    numSlots = 1;
+    slotTime[0] = 0;
+    for (i = 0; i < numEnds; i++) {
+        if ((numSlots == 1) || ((endCounts[i] - slotTime[numSlots - 1]) >= RC_Counts(MINEDGEGAP))) {
+            slotTime[numSlots] = endCounts[i];
+            for (lat = 0; lat < RC_NUMLATS; lat++) {
+                Schedule[numSlots].Lat[lat] = 0;
+            }
+            numSlots++;
+        }
+        Schedule[numSlots - 1].Lat[rcLatMap[endPin[i]]] |= rcBitsMap[endPin[i]];
+    }
+    // the timer resets on the count after it matches PR4
+    for (i = 0; i < numSlots - 1; i++) {
+        Schedule[i].Period = slotTime[i + 1] - slotTime[i] - 1;
+    }
+    Schedule[numSlots - 1].Period = RC_Counts(RCPERIODTIME) - slotTime[numSlots - 1] - 1;
+}
+
+
+/**
+ * @Function RC_StepMoves(void) -- PRIVATE FUNCTION
+ * @param none
+ * @return none
+ * @brief Moves each ramping pin one frame along its line from moveStart to
+ *        moveTarget. A pin that reached its target on the last step is done
+ *        now that the frame with the target in it has gone out.
+ * @note Called from the last slot of a frame, ahead of RC_BuildSchedule. */
+void RC_StepMoves(void)
+{
+    char i;
+
+    for (i = 0; i < RCPINCOUNT; i++) {
+        if (pinsMoving & (1 << i)) {
+            if (moveFrame[i] < moveFrames[i]) {
+                moveFrame[i]++;
+                RCupTime[i] = moveStart[i] + ((int) (moveTarget[i] - moveStart[i]) * moveFrame[i]) / moveFrames[i];
+                scheduleStale = TRUE;
+            } else {
+                pinsMoving &= ~(1 << i);
+            }
+        }
+    }
+}
+
+
 /*******************************************************************************
  * INTERRUPT SERVICE ROUTINES                                                  *
  ******************************************************************************/
@@ -470,22 +658,20 @@ void RC_ShutDown(void)
  * @Function Timer4IntHandler -- ISR ROUTINE
  * @param none
  * @return none
- * @brief Implements the RC_Servo state machine through the TIMER4 ISR.
- *        Raises and Lowers the appropriate RC pins, and implements a
- *        countdown to get to the 20msec repetition rate.
- * @note Adding and Removing pins are handled within the idling state, after
- *       all pins have gone through their Pulse. Shutdown also occurs in this
- *       state. Potential for idle state to not have any time left, if all 10
- *       servos are enabled and at their largest value.
- * @author Gabriel Hugh Elkaim, 2013.08.16, 23:26 */
+ * @brief Plays the schedule built by RC_BuildSchedule, one slot per interrupt.
+ *        Each slot sets the time to the next one in PR4, TIMER4 restarts from 0
+ *        on each match, so the edges do not drift with the interrupt latency.
+ * @note Adding and Removing pins, and new pulse times, are handled in the last
+ *       slot of the frame, after all pins have gone through their Pulse. This
+ *       is at least RCPERIODTIME - MAXPULSE before the next edge. Shutdown
+ *       occurs on the next interrupt after RC_End. */
 
 void __ISR(_TIMER_4_VECTOR) Timer4IntHandler(void)
 {
-    static char numPin = 0;
-    static unsigned short int curPin = 0x001;
-    static char indexPin = 0;
-    static char prevPin = -1;
-    unsigned short int currentTime;
+    const RCslot *slot = &Schedule[slotIndex];
+#ifdef RC_SERVO_TEST
+    unsigned int start = _CP0_GET_COUNT();
+#endif
 
     IFS0bits.T4IF = 0;
 
@@ -495,78 +681,37 @@ void __ISR(_TIMER_4_VECTOR) Timer4IntHandler(void)
         return;
     }
 
-    switch (RCstate) {
-    case none:
-        // no pins active. Reset for 1.5msec, check for pins to add
-        PR4=TMR4+uSEC*SERVOCENTER;    
-        if (pinsToAdd) {
-            RC_InstallPins(); // new pins active, reset to start pulses
-            curPin = 0x001;
-            indexPin = 0;
-            numPin = 1;
-            RCstate = pulsing;
-        }
-        break;
-
-    case pulsing:
-        // cycle through all active pins, one each interrupt, raising the current
-        // and lowering the previous ones until you have done them all
-        // Find next pin in RCpinsActive
-        while (!(curPin & RCpinsActive)) {
-            curPin <<= 1;
-            indexPin++;
-        }
-        uSecondsLeftToGo -= RC_GetTime(indexPin);
-        RC_SetPin(indexPin);
-        PR4=TMR4+(uSEC * RCupTime[indexPin]);
-        if (numPin != 1) { // not on first pin, lower previous pin
-            RC_ClearPin(prevPin);
-        }
-        prevPin = indexPin;
-        curPin <<= 1;
-        indexPin++;
-        numPin++;
-        if (numPin > numRCPins) { // finished all pins, go to idle state
-            RCstate = idling;
-
-        }
-        break;
-
-
-    case idling:
-        // lower previous pin and reset pin counters to keep track of position
-        RC_ClearPin(prevPin);
-        currentTime = TMR4;
-        if (uSecondsLeftToGo <= 0) {
-            RCstate = pulsing;
-            IFS0bits.T4IF = 1;
-        } else if ((uSecondsLeftToGo * uSEC + currentTime) < FULLOVERFLOW) {
-            PR4=(currentTime + uSEC * uSecondsLeftToGo);
-            RCstate = pulsing;
-        } else { // need to cycle through
-            uSecondsLeftToGo -= MAXPULSE;
-            PR4=(currentTime + uSEC * MAXPULSE);
-        }
-
-        if (RCstate == pulsing) {// switching back from idle to pulsing
-            uSecondsLeftToGo = RCPERIODTIME;
-            curPin = 0x001;
-            indexPin = 0;
-            numPin = 1;
-        }
-
+    PR4 = slot->Period;
+    if (slotIndex == 0) {
+        LATBSET = slot->Lat[RC_LATB];
+        LATDSET = slot->Lat[RC_LATD];
+        LATESET = slot->Lat[RC_LATE];
+        LATFSET = slot->Lat[RC_LATF];
+    } else {
+        LATBCLR = slot->Lat[RC_LATB];
+        LATDCLR = slot->Lat[RC_LATD];
+        LATECLR = slot->Lat[RC_LATE];
+        LATFCLR = slot->Lat[RC_LATF];
+    }
+    slotIndex++;
+    if (slotIndex >= numSlots) {
+        // end of the pulses, all pins stay low until the next frame
+        slotIndex = 0;
         if (pinsToAdd) RC_InstallPins();
         if (pinsToRemove) RC_DeletePins();
-        if (numRCPins == 0) {
-            uSecondsLeftToGo = RCPERIODTIME;
-            RCstate = none;
-        }
-        break;
-
-    default:
-        dbprintf("\nRC_Servo: ERROR, module in undefined state");
-        break;
+        if (pinsMoving) RC_StepMoves();
+        if (scheduleStale) RC_BuildSchedule();
     }
+#ifdef RC_SERVO_TEST
+    countInterrupts++;
+    countTicks += _CP0_GET_COUNT() - start;
+    if (slotIndex == 0) {
+        frameInterrupts = countInterrupts;
+        frameTicks = countTicks;
+        countInterrupts = 0;
+        countTicks = 0;
+    }
+#endif
 }
 
 
@@ -603,8 +748,8 @@ int main(void)
     BOARD_Init();
     DELAY(A_LOT);
     printf("\nCMPE118 RC_SERVO module test harness.");
-    printf("\nTiming information: PBClock %d (%3.2f Mhz), Counts per uSec: %d",
-            F_PB, F_PB_IN_KHZ / 1000.0, uSEC);
+    printf("\nTiming information: PBClock %d (%3.2f Mhz), Counts per mSec: %d",
+            F_PB, F_PB_IN_KHZ / 1000.0, COUNTS_PER_MS);
     printf("\nInitial Test, ensure all functions return ERROR "
             "before RC_Init() is run\n");
 
@@ -1129,6 +1274,24 @@ int main(void)
     printf("\nRC_ChangePending() Testing complete.");
     FlushPrintBuffer();
 
+    /***************************************************************************
+     *            FRAME LOAD                                                   *
+     ***************************************************************************/
+    printf("\n\nInterrupt load per %d uSec frame:", RCPERIODTIME);
+    DELAY(A_LOT);
+    printf("\nAll pins active: %d interrupts, %d core ticks (%d.%02d%% CPU)", frameInterrupts,
+            frameTicks, (frameTicks * 100) / (RCPERIODTIME * CORE_TICKS_PER_US),
+            ((frameTicks * 10000) / (RCPERIODTIME * CORE_TICKS_PER_US)) % 100);
+    RC_RemovePins(ALLRCPINS & ~RC_PORT);
+    while (RC_ChangePending()) {
+        DELAY(A_BIT);
+    }
+    DELAY(A_LOT);
+    printf("\nOne pin active: %d interrupts, %d core ticks (%d.%02d%% CPU)", frameInterrupts,
+            frameTicks, (frameTicks * 100) / (RCPERIODTIME * CORE_TICKS_PER_US),
+            ((frameTicks * 10000) / (RCPERIODTIME * CORE_TICKS_PER_US)) % 100);
+    FlushPrintBuffer();
+
     /***************************************************************************
      *            TEST RC_END()                                                *
      ***************************************************************************/
@@ -15,7 +15,8 @@
  *
  * Pins are attached to the RC_Servo module using #defined RC_PORTxxx from the available
  * list of pins below (not all pins are available for RC servo use). All enabled pins will
- * start with a 1.5msec pulse width (centered).
+ * start with a 1.5msec pulse width (centered). All pins start their pulses together at
+ * the top of each frame, and pins whose pulses end together are lowered together.
  *
  * NOTE: This module uses TIMER4 for its internal timing and interrupts. Certain servos
  *       have a larger range and can be driven from 0.5mS to 2.5mse, in this case, change
@@ -104,6 +105,24 @@ unsigned short int RC_ListPins(void);
  * @author Gabriel Hugh Elkaim, 2011.12.15 16:42 */
 char RC_SetPulseTime(unsigned short int RCpin, unsigned short int pulseTime);
 
+/**
+ * @Function RC_MovePulseTime(unsigned short int RCpin, unsigned short int pulseTime,
+ *           unsigned short int moveTime)
+ * @param RCpin - use #defined RC_PORTxxx (only one)
+ * @param pulseTime - pulse width in uSeconds from [1000 to 2000] to end up at
+ * @param moveTime - mSec to get there in
+ * @return SUCCESS or ERROR
+ * @brief Ramps the pulse width from where it is now to pulseTime, one step per
+ *        frame. RC_IsMoving stays TRUE until the frame with pulseTime has gone out,
+ *        and RC_SetPulseTime stops the move where it is. */
+char RC_MovePulseTime(unsigned short int RCpin, unsigned short int pulseTime, unsigned short int moveTime);
+
+/**
+ * @Function RC_IsMoving(unsigned short int RCpins)
+ * @param RCpins - use #defined RC_PORTxxx OR'd together
+ * @return TRUE if any of the pins is still moving under RC_MovePulseTime */
+char RC_IsMoving(unsigned short int RCpins);
+
 /**
  * @Function RcGetPulseTime(unsigned short int RCpin)
  * @param RCpin - use #defined RC_PORTxxx (only one)
@@ -0,0 +1,274 @@
+/*
+ * File: SensorHealth.c
+ *
+ * An open sensor reads near full scale and a wall at contact still reads well above
+ * ground, so a window of readings at ground can only be a short or a lost supply.
+ * Driving past a wall moves a reading by far less than HEALTH_JUMP in 10 ms, while a
+ * floating input jumps by hundreds of counts. The variance is only checked for zero
+ * away from full scale, since a sensor at full scale can legitimately read flat.
+ * A fault is raised on the first bad window and cleared after a whole window
+ * without one.
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+//#define SENSORHEALTH_TEST
+
+#ifndef SENSORHEALTH_TEST
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "SensorHealth.h"
+#include "AnalogTapeSensors.h"
+#include "BdayFSM.h"
+#else
+#include <stdint.h>
+#define TRUE 1
+#define FALSE 0
+#define NUM_ANALOG_TAPE 4           //as in AnalogTapeSensors.h
+#define HEALTH_WINDOW 32            //as in SensorHealth.h
+#define HEALTH_OK 0
+#define HEALTH_RAILED 1
+#define HEALTH_ERRATIC 2
+#define HEALTH_STUCK 3
+#define SENSOR_FAULT 1
+typedef struct {
+    int EventType;
+    uint16_t EventParam;
+} ES_Event;
+static uint16_t Analog_TapeRead(unsigned char Sensor);
+static uint8_t PostBdayFSM(ES_Event ThisEvent);
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define HEALTH_RAIL_LOW 16          //A/D counts, readings at or under this hit the rail
+#define HEALTH_FULL_SCALE 1000      //flat readings above this are an open sensor
+#define HEALTH_JUMP 250             //A/D counts between readings 10 ms apart
+#define HEALTH_MAX_JUMPS 6          //jumps allowed in a window
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+typedef struct {
+    uint16_t History[HEALTH_WINDOW];
+    uint32_t RailBits;              //bit per slot, reading was at the rail
+    uint32_t JumpBits;              //bit per slot, reading jumped from the one before
+    uint32_t Sum;
+    uint32_t SumSq;
+    unsigned char Rails;
+    unsigned char Jumps;
+    unsigned char Clean;            //readings since the last bad window
+    unsigned char Fault;
+} SensorWindow_t;
+
+static SensorWindow_t Windows[NUM_ANALOG_TAPE];
+static unsigned char Slot = 0;
+static unsigned char Filled = 0;
+static uint8_t HealthMask = (1 << NUM_ANALOG_TAPE) - 1;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+void SensorHealth_Update(void)
+{
+    SensorWindow_t *Window;
+    ES_Event FaultEvent;
+    uint16_t Reading, Oldest, Previous;
+    uint32_t Bit = (uint32_t) 1 << Slot;
+    uint32_t Spread;
+    uint8_t Mask = 0;
+    unsigned char Fault, i;
+
+    for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+        Window = &Windows[i];
+        Reading = Analog_TapeRead(i);
+        Previous = Window->History[(Slot + HEALTH_WINDOW - 1) % HEALTH_WINDOW];
+        //take the oldest reading out of the sums and put the new one in its place
+        if (Filled == HEALTH_WINDOW) {
+            Oldest = Window->History[Slot];
+            Window->Sum -= Oldest;
+            Window->SumSq -= (uint32_t) Oldest * Oldest;
+            Window->Rails -= (Window->RailBits & Bit) ? 1 : 0;
+            Window->Jumps -= (Window->JumpBits & Bit) ? 1 : 0;
+        }
+        Window->History[Slot] = Reading;
+        Window->Sum += Reading;
+        Window->SumSq += (uint32_t) Reading * Reading;
+        Window->RailBits &= ~Bit;
+        Window->JumpBits &= ~Bit;
+        if (Reading <= HEALTH_RAIL_LOW) {
+            Window->RailBits |= Bit;
+            Window->Rails++;
+        }
+        if ((Filled != 0) && (abs((int) Reading - (int) Previous) > HEALTH_JUMP)) {
+            Window->JumpBits |= Bit;
+            Window->Jumps++;
+        }
+        if (Filled < (HEALTH_WINDOW - 1)) {
+            continue;
+        }
+
+        //n*sum(x^2) - sum(x)^2 is zero only when every reading in the window is equal
+        Spread = (Window->SumSq * HEALTH_WINDOW) - (Window->Sum * Window->Sum);
+        if (Window->Rails == HEALTH_WINDOW) {
+            Fault = HEALTH_RAILED;
+        } else if (Window->Jumps > HEALTH_MAX_JUMPS) {
+            Fault = HEALTH_ERRATIC;
+        } else if ((Spread == 0) && (Reading < HEALTH_FULL_SCALE)) {
+            Fault = HEALTH_STUCK;
+        } else {
+            Fault = HEALTH_OK;
+        }
+        if (Fault != HEALTH_OK) {
+            Window->Fault = Fault;
+            Window->Clean = 0;
+        } else if ((Window->Fault != HEALTH_OK) && (++Window->Clean >= HEALTH_WINDOW)) {
+            Window->Fault = HEALTH_OK;
+        }
+        if (Window->Fault == HEALTH_OK) {
+            Mask |= (1 << i);
+        }
+    }
+    Slot = (Slot + 1) % HEALTH_WINDOW;
+    if (Filled < HEALTH_WINDOW) {
+        Filled++;
+    }
+    if (Filled < HEALTH_WINDOW) {
+        return;
+    }
+
+    if (Mask != HealthMask) {
+        HealthMask = Mask;
+        FaultEvent.EventType = SENSOR_FAULT;
+        FaultEvent.EventParam = Mask;
+        PostBdayFSM(FaultEvent);
+    }
+}
+
+uint8_t SensorHealth_GetMask(void)
+{
+    return HealthMask;
+}
+
+unsigned char SensorHealth_IsHealthy(unsigned char Sensor)
+{
+    if (Sensor >= NUM_ANALOG_TAPE) {
+        return FALSE;
+    }
+    return (HealthMask & (1 << Sensor)) ? TRUE : FALSE;
+}
+
+unsigned char SensorHealth_GetFault(unsigned char Sensor)
+{
+    if (Sensor >= NUM_ANALOG_TAPE) {
+        return HEALTH_OK;
+    }
+    return Windows[Sensor].Fault;
+}
+
+#ifdef SENSORHEALTH_TEST
+/*
+ * Runs four simulated sensors through SensorHealth_Update at the WallEstimator rate:
+ * one sees a wall come and go smoothly, one floats for 4 s, one is shorted to ground
+ * for 3 s and one is open and reads full scale throughout. Reports when each fault is
+ * raised and cleared, and counts a fault on a good sensor, or a bad one missed for more
+ * than a window, as an error. Built on a PC with
+ *     gcc -DSENSORHEALTH_TEST SensorHealth.c -o healthtest
+ */
+#define TEST_TICK_MS 10             //WALL_ESTIMATE_TICKS
+#define TEST_STEPS 2000
+#define TEST_SMOOTH 0
+#define TEST_FLOATING 1
+#define TEST_SHORTED 2
+#define TEST_OPEN 3
+#define FLOAT_START 400
+#define FLOAT_END 800
+#define SHORT_START 900
+#define SHORT_END 1200
+
+static uint16_t Readings[NUM_ANALOG_TAPE];
+static int Step;
+static int Raised[NUM_ANALOG_TAPE];
+static int Cleared[NUM_ANALOG_TAPE];
+
+static uint16_t Analog_TapeRead(unsigned char Sensor)
+{
+    return Readings[Sensor];
+}
+
+static uint8_t PostBdayFSM(ES_Event ThisEvent)
+{
+    static uint8_t LastMask = (1 << NUM_ANALOG_TAPE) - 1;
+    unsigned char i;
+
+    printf("%5d ms: SENSOR_FAULT mask 0x%x\n", Step * TEST_TICK_MS, ThisEvent.EventParam);
+    for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+        if ((LastMask & (1 << i)) && !(ThisEvent.EventParam & (1 << i))) {
+            Raised[i] = Step;
+        } else if (!(LastMask & (1 << i)) && (ThisEvent.EventParam & (1 << i))) {
+            Cleared[i] = Step;
+        }
+    }
+    LastMask = ThisEvent.EventParam;
+    return TRUE;
+}
+
+int main(void)
+{
+    int Wall;
+    unsigned char i;
+    unsigned int Errors = 0;
+
+    srand(1);
+    for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+        Raised[i] = -1;
+        Cleared[i] = -1;
+    }
+    for (Step = 0; Step < TEST_STEPS; Step++) {
+        //a wall passing at driving speed, under 10 counts a reading
+        Wall = ((Step / 150) % 2) ? 1023 - (Step % 150) * 5 : 300 + (Step % 150) * 4;
+        if (Wall < 200) {
+            Wall = 200;
+        }
+        if (Wall > 1023) {
+            Wall = 1023;
+        }
+        Readings[TEST_SMOOTH] = Wall + rand() % 5;
+        Readings[TEST_FLOATING] = ((Step >= FLOAT_START) && (Step < FLOAT_END)) ? rand() % 1024 : Wall + rand() % 3;
+        Readings[TEST_SHORTED] = ((Step >= SHORT_START) && (Step < SHORT_END)) ? rand() % 4 : Wall;
+        Readings[TEST_OPEN] = 1023;
+        SensorHealth_Update();
+    }
+    if ((Raised[TEST_SMOOTH] >= 0) || (Raised[TEST_OPEN] >= 0)) {
+        printf("a good sensor was faulted\n");
+        Errors++;
+    }
+    if ((Raised[TEST_FLOATING] < FLOAT_START) || (Raised[TEST_FLOATING] > FLOAT_START + HEALTH_WINDOW)) {
+        printf("floating input missed\n");
+        Errors++;
+    } else {
+        printf("floating input caught in %d ms\n", (Raised[TEST_FLOATING] - FLOAT_START) * TEST_TICK_MS);
+    }
+    if ((Raised[TEST_SHORTED] < SHORT_START) || (Raised[TEST_SHORTED] > SHORT_START + HEALTH_WINDOW)) {
+        printf("shorted input missed\n");
+        Errors++;
+    } else {
+        printf("shorted input caught in %d ms\n", (Raised[TEST_SHORTED] - SHORT_START) * TEST_TICK_MS);
+    }
+    if (SensorHealth_GetMask() != ((1 << NUM_ANALOG_TAPE) - 1)) {
+        printf("faults still raised at the end, mask 0x%x\n", SensorHealth_GetMask());
+        Errors++;
+    }
+    printf("%u errors\n", Errors);
+    return Errors ? 1 : 0;
+}
+#endif /* SENSORHEALTH_TEST */
@@ -0,0 +1,59 @@
+/*
+ * File: SensorHealth.h
+ *
+ * Health monitor for the analog wall sensors. A loose cable leaves the A/D pin floating
+ * or pulled to a rail, and the reading never crosses a threshold again. Each sensor is
+ * checked over a sliding window of its last HEALTH_WINDOW readings for rail hits,
+ * sample to sample jumps and a variance of zero. When the set of healthy sensors
+ * changes, SENSOR_FAULT is posted to BdayFSM with the new health mask as its
+ * parameter. A faulted sensor is read through its partner on the same side, see
+ * Analog_TapeGetSource.
+ */
+
+#ifndef SensorHealth_H
+#define SensorHealth_H
+
+#include "BOARD.h"
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define HEALTH_WINDOW 32            //readings, 320 ms at the WallEstimator rate
+
+//reasons returned by SensorHealth_GetFault
+#define HEALTH_OK 0
+#define HEALTH_RAILED 1             //every reading at ground
+#define HEALTH_ERRATIC 2            //too many large jumps, a floating input
+#define HEALTH_STUCK 3              //not a single count of noise away from full scale
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+/**
+ * @Function SensorHealth_Update(void)
+ * @return None
+ * @brief Adds the latest reading of every sensor to its window and grades it. The
+ *        window statistics are kept as running sums, so each call is O(1) per sensor.
+ *        Called by WallEstimator every WALL_ESTIMATE_TICKS. */
+void SensorHealth_Update(void);
+
+/**
+ * @Function SensorHealth_GetMask(void)
+ * @return bit (1 << ANALOG_TAPE_x) set for each healthy sensor */
+uint8_t SensorHealth_GetMask(void);
+
+/**
+ * @Function SensorHealth_IsHealthy(unsigned char Sensor)
+ * @param Sensor - ANALOG_TAPE_x
+ * @return TRUE unless the sensor is faulted, FALSE for a bad sensor */
+unsigned char SensorHealth_IsHealthy(unsigned char Sensor);
+
+/**
+ * @Function SensorHealth_GetFault(unsigned char Sensor)
+ * @param Sensor - ANALOG_TAPE_x
+ * @return HEALTH_x reason the sensor is faulted, HEALTH_OK when healthy */
+unsigned char SensorHealth_GetFault(unsigned char Sensor);
+
+#endif /* SensorHealth_H */
@@ -7,8 +7,8 @@
 //#define SERVO_TEST
 #define TURNSTILE_PIN RC_PORTY07
 
-#define MIDDLE 2000
-#define OPEN 1500
+#define MIDDLE TURNSTILE_SEND
+#define OPEN TURNSTILE_STOP
 
 unsigned char TurnStile_Init(void){
     
@@ -18,15 +18,28 @@ unsigned char TurnStile_Init(void){
     
 }
 
+//both ramp over TURNSTILE_MOVE_MS, CheckTurnstile posts TURNSTILE_ARRIVED at the end
 void Send_Ball(void){
     
-    RC_SetPulseTime(TURNSTILE_PIN, MIDDLE);
+    RC_MovePulseTime(TURNSTILE_PIN, MIDDLE, TURNSTILE_MOVE_MS);
     
 }
 
 void Stop_Ball(void){
     
-    RC_SetPulseTime(TURNSTILE_PIN, OPEN);
+    RC_MovePulseTime(TURNSTILE_PIN, OPEN, TURNSTILE_MOVE_MS);
+    
+}
+
+unsigned char Turnstile_IsMoving(void){
+    
+    return RC_IsMoving(TURNSTILE_PIN);
+    
+}
+
+unsigned short Turnstile_GetPosition(void){
+    
+    return RC_GetPulseTime(TURNSTILE_PIN);
     
 }
 
@@ -12,8 +12,15 @@
 #include <xc.h>
 #include <stdio.h>
 
+//turnstile pulse widths, TURNSTILE_ARRIVED carries the one it got to
+#define TURNSTILE_SEND 2000
+#define TURNSTILE_STOP 1500
+#define TURNSTILE_MOVE_MS 100   //one move between them, about the servo's own top speed
+
 unsigned char TurnStile_Init(void);
 void Stop_Ball(void);
 void Send_Ball(void);
+unsigned char Turnstile_IsMoving(void);
+unsigned short Turnstile_GetPosition(void);
 
 
@@ -110,6 +110,7 @@ ES_Event RunTESTEventService(ES_Event ThisEvent)
     //printf("event type : %d", ThisEvent.EventType);
     switch (ThisEvent.EventType){
         case (ES_TIMEOUT):
+            IO_PortsTakeSnapshot();
             CheckDigitalTape();
             CheckAnalogTape();
             CheckBumpers();
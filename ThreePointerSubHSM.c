@@ -34,13 +34,14 @@
 #include "TwoPointerSubHSM.h"
 #include "Servo.h"
 #include "Motor_Driver.h"
+#include "Flywheel.h"
 #include "BCEventChecker.h"
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
  ******************************************************************************/
 
 #define TURN_3PT_TIMER 5
-#define TURN_3PT_TICKS 200
+#define TURN_3PT_TICKS Params_Get(PARAM_TURN_3PT_TICKS)
 
 typedef enum {
     Init,
@@ -64,6 +65,8 @@ static const char *StateNames[] = {
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
 
+static void ThreePointer_Shoot(void);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
@@ -72,6 +75,8 @@ static const char *StateNames[] = {
 
 static ThreePointerSubHSMState_t CurrentState = Init; // <- change name to match ENUM
 static uint8_t MyPriority;
+static unsigned char Shot_Waiting = FALSE;   //the shot is due, held for FLYWHEEL_READY
+static uint16_t Release_Ticks;                 //gate held open this long once it gets there
 
 
 /*******************************************************************************
@@ -116,6 +121,7 @@ ES_Event RunThreePointerSubHSM(ES_Event ThisEvent)
 switch (CurrentState) {
         case Init: // If current state is initial Psedudo State
             CurrentState = Turn;
+            Shot_Waiting = FALSE;
             break;
 
         case Turn: // in the first state, replace this with correct names
@@ -141,10 +147,13 @@ switch (CurrentState) {
                 if (ThisEvent.EventParam == TURN_3PT_TIMER){
                     LeftWheelSpeed(0);
                     RightWheelSpeed(0);
-                    ES_Timer_InitTimer(BALL_RELEASE_TIMER, BALL_RELEASE_TICKS + 100);
-                    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                    Send_Ball();
-                    
+                    //hold the shot for the flywheels, at most a spin-up from rest
+                    if (Shot_Waiting || Flywheel_MayShoot()) {
+                        ThreePointer_Shoot();
+                    } else {
+                        Shot_Waiting = TRUE;
+                        ES_Timer_InitTimer(TURN_3PT_TIMER, FLYWHEEL_WAIT_TICKS);
+                    }
                 } 
                 if (ThisEvent.EventParam == BALL_RELEASE_TIMER){
                     //ES_Timer_InitTimer(TURN_1PT_TIMER, TURN_1PT_TICKS);
@@ -164,6 +173,14 @@ switch (CurrentState) {
                 }
                 
             }
+            if ((ThisEvent.EventType == FLYWHEEL_READY) && Shot_Waiting) {
+                ES_Timer_StopTimer(TURN_3PT_TIMER);
+                ThreePointer_Shoot();
+            }
+            //the gate is open, hold it there while the ball goes through
+            if ((ThisEvent.EventType == TURNSTILE_ARRIVED) && (ThisEvent.EventParam == TURNSTILE_SEND)) {
+                ES_Timer_InitTimer(BALL_RELEASE_TIMER, Release_Ticks);
+            }
             break;
         case Turn_Back:
             if (Side == RIGHT){
@@ -194,3 +211,20 @@ switch (CurrentState) {
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/**
+ * @Function ThreePointer_Shoot(void)
+ * @return None
+ * @brief Releases the ball and starts the timer that ends the shot. The gate closes
+ *        Release_Ticks after TURNSTILE_ARRIVED says it is open. */
+static void ThreePointer_Shoot(void)
+{
+    int Ticks;
+
+    Shot_Waiting = FALSE;
+    Ticks = BALL_RELEASE_TICKS + 100 - TURNSTILE_MOVE_MS;
+    //the param can be set negative over serial
+    Release_Ticks = (Ticks > 0) ? Ticks : 1;
+    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
+    Send_Ball();
+    Flywheel_Shot();
+}
@@ -1,3 +1,6 @@
+//#define TRACKWIRE_TEST
+
+#ifndef TRACKWIRE_TEST
 #include "ES_Configure.h"
 #include "BCEventChecker.h"
 #include "BumperSensor.h"
@@ -12,18 +15,285 @@
 #include "TrackWire.h"
 
 #include <xc.h>
+#include <sys/attribs.h>
+#include <stdio.h>
+#else
+#include <stdint.h>
 #include <stdio.h>
+#define TRUE 1
+#define FALSE 0
+#define SUCCESS 1
+#define ERROR 0
+#define TRACKWIRE_FREQUENCY 25000   //as in TrackWire.h
+#define TRACKWIRE_BAND 3000
+#define CORE_TICKS_PER_US 40        //as in BOARD.h
+#define BOARD_GetPBClock() 40000000
+static unsigned int PR3;
+unsigned int TrackWire_GetFrequency(void);
+char TrackWire_SetBand(unsigned int MinFrequency, unsigned int MaxFrequency);
+#endif
+
+/*
+ * The track wire detector output is timestamped on every rising edge by input capture 3
+ * (RD10, PORTY06) against Timer3, which free runs at PB/8 = 5MHz. The flywheel PWM
+ * group may set PR3 to its period, which only shortens the wrap. The interrupt fires
+ * every 4th capture and checks each period against the carrier band; the wire is only
+ * reported once TRACKWIRE_LOCK_PERIODS periods in a row are in band, and is dropped when
+ * no in band period has been seen for TRACKWIRE_TIMEOUT_US.
+ */
+//#define TRACKWIRE_POLLED    //old detector on PORTZ03, read as a plain digital input
+
+#ifdef TRACKWIRE_POLLED
+#define TRACKWIRE PIN3  //PORTZ
+#endif
+
+#define CAPTURE_FREQUENCY (BOARD_GetPBClock() >> 3)
+#define CORE_TICKS_PER_CAPTURE 8 //core timer and PB clock are both 40MHz
+#define TRACKWIRE_LOCK_PERIODS 6
+#define TRACKWIRE_TIMEOUT_US 1000
 
-#define TRACKWIRE PORTZ03_BIT
+static volatile unsigned char OnWire = FALSE;
+static volatile uint32_t LastInBand;     //core timer at the last in band period
+static volatile uint16_t LastPeriod;     //Timer3 ticks of the last in band period
+static uint16_t MinPeriod;
+static uint16_t MaxPeriod;
+static uint16_t PrevCapture;
+static unsigned char PrevValid = FALSE;
+static unsigned char InBandCount;
 
+static void TrackWire_Capture(uint16_t Capture, uint32_t Now);
+
+#ifndef TRACKWIRE_TEST
 unsigned char TrackWire_Init(void){
-    
+#ifdef TRACKWIRE_POLLED
     return IO_PortsSetPortInputs(PORTZ, PIN3);
-    
+#else
+    if (IO_PortsSetPortInputs(PORTY, PIN6) == ERROR) {
+        return ERROR;
+    }
+    TrackWire_SetBand(TRACKWIRE_FREQUENCY - TRACKWIRE_BAND, TRACKWIRE_FREQUENCY + TRACKWIRE_BAND);
+
+    //Timer3 free runs as the capture time base, unless the PWM already runs it at 1:8
+    if (!T3CONbits.ON) {
+        T3CON = 0;
+        T3CONbits.TCKPS = 0b011; //1:8
+        PR3 = 0xFFFF;
+        TMR3 = 0;
+        T3CONbits.ON = 1;
+    }
+
+    IC3CON = 0;
+    IC3CONbits.ICTMR = 0; //Timer3
+    IC3CONbits.ICI = 0b11; //interrupt on every 4th capture
+    IC3CONbits.ICM = 0b011; //every rising edge
+    while (IC3CONbits.ICBNE) {
+        (void) IC3BUF;
+    }
+    IFS0bits.IC3IF = 0;
+    IPC3bits.IC3IP = 3;
+    IEC0bits.IC3IE = 1;
+    IC3CONbits.ON = 1;
+    return SUCCESS;
+#endif
 }
 
 unsigned char ReadTrackWire(void){
-    
-    return TRACKWIRE;    
-    
+#ifdef TRACKWIRE_POLLED
+    return (IO_PortsGetSnapshot()->raw[PORTZ] & TRACKWIRE) != 0;
+#else
+    unsigned char Result;
+
+    //carrier lost, there are no edges to run the interrupt so time out here. The
+    //interrupt is held off so LastInBand cannot move past the core timer read.
+    IEC0bits.IC3IE = 0;
+    if (OnWire && ((_CP0_GET_COUNT() - LastInBand) > (TRACKWIRE_TIMEOUT_US * CORE_TICKS_PER_US))) {
+        OnWire = FALSE;
+    }
+    Result = OnWire;
+    IEC0bits.IC3IE = 1;
+    return Result;
+#endif
+}
+#endif /* TRACKWIRE_TEST */
+
+unsigned int TrackWire_GetFrequency(void){
+    uint16_t Period = LastPeriod;
+
+    if (!OnWire || (Period == 0)) {
+        return 0;
+    }
+    return CAPTURE_FREQUENCY / Period;
+}
+
+char TrackWire_SetBand(unsigned int MinFrequency, unsigned int MaxFrequency){
+    if ((MinFrequency == 0) || (MinFrequency >= MaxFrequency) || (MaxFrequency > CAPTURE_FREQUENCY / 4)) {
+        return ERROR;
+    }
+    MinPeriod = CAPTURE_FREQUENCY / MaxFrequency;
+    MaxPeriod = CAPTURE_FREQUENCY / MinFrequency;
+    return SUCCESS;
+}
+
+/**
+ * @function TrackWire_Capture(uint16_t Capture, uint32_t Now)
+ * @param Capture - Timer3 value of a rising edge
+ * @param Now - core timer when the capture was read
+ * @brief Measures the period since the previous edge and qualifies the carrier
+ */
+static void TrackWire_Capture(uint16_t Capture, uint32_t Now){
+    uint16_t Period;
+
+    if (PrevValid) {
+        //Timer3 wraps at PR3, the period is only valid for gaps shorter than a wrap
+        if (Capture >= PrevCapture) {
+            Period = Capture - PrevCapture;
+        } else {
+            Period = Capture + (PR3 - PrevCapture) + 1;
+        }
+        if ((Period >= MinPeriod) && (Period <= MaxPeriod)) {
+            if (InBandCount < TRACKWIRE_LOCK_PERIODS) {
+                InBandCount++;
+            }
+            if (InBandCount >= TRACKWIRE_LOCK_PERIODS) {
+                OnWire = TRUE;
+                LastInBand = Now;
+                LastPeriod = Period;
+            }
+        } else {
+            InBandCount = 0;
+        }
+    }
+    PrevCapture = Capture;
+    PrevValid = TRUE;
+}
+
+#if !defined(TRACKWIRE_POLLED) && !defined(TRACKWIRE_TEST)
+
+static uint32_t LastCapture;             //core timer at the last capture interrupt
+
+/**
+ * @function IC3IntHandler
+ * @brief Empties the capture buffer into the period checker
+ * @note This function is not to be called by the user */
+void __ISR(_INPUT_CAPTURE_3_VECTOR) IC3IntHandler(void)
+{
+    uint32_t Now = _CP0_GET_COUNT();
+
+    //after a long quiet time Timer3 may have wrapped, so the first edge has no period
+    if ((Now - LastCapture) > ((PR3 + 1) * CORE_TICKS_PER_CAPTURE)) {
+        PrevValid = FALSE;
+        InBandCount = 0;
+    }
+    LastCapture = Now;
+    while (IC3CONbits.ICBNE) {
+        TrackWire_Capture(IC3BUF, Now);
+    }
+    IFS0bits.IC3IF = 0;
+}
+#endif
+
+#ifdef TRACKWIRE_TEST
+/*
+ * Runs simulated edge streams through the same period checker the capture interrupt
+ * uses. Edge times are generated in Timer3 ticks and handed over in batches of four, as
+ * the interrupt would. Reports detection time in carrier cycles and false detections.
+ * Built on a PC with
+ *     gcc -DTRACKWIRE_TEST TrackWire.c -o trackwiretest
+ */
+#define TICKS_PER_US 5
+#define TEST_TRIALS 200
+
+static uint32_t Seed = 42;
+
+static uint32_t Random(uint32_t Range){
+    Seed = Seed * 1103515245 + 12345;
+    return (Seed >> 8) % Range;
+}
+
+static void ResetDetector(void){
+    OnWire = FALSE;
+    PrevValid = FALSE;
+    InBandCount = 0;
+}
+
+/*
+ * Feeds edges for Duration ticks. Carrier is the carrier period in ticks (0 for none),
+ * Jitter the peak edge jitter in ticks and NoiseRate the mean noise edge spacing in
+ * ticks (0 for none). Returns the tick at which the wire was declared, or 0.
+ */
+static uint32_t RunStream(uint32_t Duration, uint32_t Carrier, uint32_t Jitter, uint32_t NoiseRate){
+    uint32_t NextCarrier = Carrier ? Random(Carrier) : Duration;
+    uint32_t NextNoise = NoiseRate ? Random(2 * NoiseRate) : Duration;
+    uint32_t Edge;
+    unsigned char Batch = 0;
+
+    while (1) {
+        Edge = (NextCarrier <= NextNoise) ? NextCarrier : NextNoise;
+        if (Edge >= Duration) {
+            return 0;
+        }
+        if (Edge == NextCarrier) {
+            NextCarrier += Carrier + Random(2 * Jitter + 1) - Jitter;
+        } else {
+            NextNoise += 1 + Random(2 * NoiseRate);
+        }
+        //Now only has to be monotonic for the simulation
+        TrackWire_Capture(Edge & 0xFFFF, Edge * (CORE_TICKS_PER_US / TICKS_PER_US));
+        Batch++;
+        if ((Batch == 4) && OnWire) {
+            return Edge;
+        }
+        Batch &= 3;
+    }
+}
+
+int main(void){
+    static const unsigned int Carriers[] = {TRACKWIRE_FREQUENCY, 15000, 40000};
+    static const unsigned int NoiseRates[] = {0, 1000 * TICKS_PER_US, 200 * TICKS_PER_US};
+    uint32_t Detect;
+    uint32_t Worst;
+    uint32_t Total;
+    uint32_t Hits;
+    uint32_t Period;
+    int c, n, t;
+
+    PR3 = 0xFFFF;
+    TrackWire_SetBand(TRACKWIRE_FREQUENCY - TRACKWIRE_BAND, TRACKWIRE_FREQUENCY + TRACKWIRE_BAND);
+    printf("\r\nTrack wire input capture test harness, band %d-%d Hz, %d periods to lock\r\n",
+            TRACKWIRE_FREQUENCY - TRACKWIRE_BAND, TRACKWIRE_FREQUENCY + TRACKWIRE_BAND, TRACKWIRE_LOCK_PERIODS);
+    for (c = 0; c < 3; c++) {
+        Period = (TICKS_PER_US * 1000000) / Carriers[c];
+        for (n = 0; n < 3; n++) {
+            Total = 0;
+            Worst = 0;
+            Hits = 0;
+            for (t = 0; t < TEST_TRIALS; t++) {
+                ResetDetector();
+                Detect = RunStream(20000 * TICKS_PER_US, Period, Period / 50, NoiseRates[n]);
+                if (Detect) {
+                    Hits++;
+                    Total += Detect;
+                    if (Detect > Worst) Worst = Detect;
+                }
+            }
+            printf("carrier %5u Hz noise every %3u us: detected %3lu/%d", Carriers[c],
+                    NoiseRates[n] / TICKS_PER_US, (unsigned long) Hits, TEST_TRIALS);
+            if (Hits) {
+                printf(", mean %lu cycles, worst %lu cycles", (unsigned long) ((Total / Hits) / Period),
+                        (unsigned long) (Worst / Period));
+            }
+            printf("\r\n");
+        }
+    }
+    //noise alone, edges every 40us on average over 20ms
+    Hits = 0;
+    for (t = 0; t < TEST_TRIALS; t++) {
+        ResetDetector();
+        if (RunStream(20000 * TICKS_PER_US, 0, 0, 40 * TICKS_PER_US)) {
+            Hits++;
+        }
+    }
+    printf("noise only: %lu false detections in %d trials\r\n", (unsigned long) Hits, TEST_TRIALS);
+    return 0;
 }
+#endif
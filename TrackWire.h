@@ -23,6 +23,9 @@
 #include <xc.h>
 #include <stdio.h>
 
+#define TRACKWIRE_FREQUENCY 25000 //carrier on the track wire in Hz
+#define TRACKWIRE_BAND 3000       //accepted deviation from the carrier in Hz
+
 //Initializes the Pins to be read
 unsigned char TrackWire_Init(void);
 
@@ -30,10 +33,26 @@ unsigned char TrackWire_Init(void);
  * @function BumperRead(void)
  * @param None
  * @return 1 for on track wire 0 for off
- * @brief Reads Track Wire Pin
+ * @brief Reads Track Wire Pin. The detector output is on PORTY06 (IC3) so the carrier
+ *        frequency can be checked, unless TRACKWIRE_POLLED is defined in TrackWire.c
  * @author Leo King */
 uint8_t ReadTrackWire(void);
 
+/**
+ * @function TrackWire_GetFrequency(void)
+ * @param None
+ * @return measured carrier frequency in Hz, 0 when not on the wire
+ * @brief From the last in band period captured by IC3 */
+unsigned int TrackWire_GetFrequency(void);
+
+/**
+ * @function TrackWire_SetBand(unsigned int MinFrequency, unsigned int MaxFrequency)
+ * @param MinFrequency - lowest carrier frequency accepted in Hz
+ * @param MaxFrequency - highest carrier frequency accepted in Hz
+ * @return SUCCESS or ERROR
+ * @brief Defaults to TRACKWIRE_FREQUENCY +/- TRACKWIRE_BAND at TrackWire_Init */
+char TrackWire_SetBand(unsigned int MinFrequency, unsigned int MaxFrequency);
+
 /* *****************************************************************************
  End of File
  */
@@ -34,14 +34,16 @@
 #include "TwoPointerSubHSM.h"
 #include "Servo.h"
 #include "Motor_Driver.h"
+#include "Flywheel.h"
 #include "BCEventChecker.h"
+#include "AnalogTapeSensors.h"
 /*******************************************************************************
  * MODULE #DEFINES                                                             *
  ******************************************************************************/
 
 #define TURN_2PT_TIMER 4
-#define TURNL_2PT_TICKS 50
-#define TURNR_2PT_TICKS 50
+#define TURNL_2PT_TICKS Params_Get(PARAM_TURNL_2PT_TICKS)
+#define TURNR_2PT_TICKS Params_Get(PARAM_TURNR_2PT_TICKS)
 
 typedef enum {
     Init,
@@ -66,6 +68,8 @@ static const char *StateNames[] = {
 /* Prototypes for private functions for this machine. They should be functions
    relevant to the behavior of this state machine */
 
+static void TwoPointer_Shoot(void);
+
 /*******************************************************************************
  * PRIVATE MODULE VARIABLES                                                            *
  ******************************************************************************/
@@ -74,6 +78,8 @@ static const char *StateNames[] = {
 
 static TwoPointerSubHSMState_t CurrentState = Init; // <- change name to match ENUM
 static uint8_t MyPriority;
+static unsigned char Shot_Waiting = FALSE;   //the shot is due, held for FLYWHEEL_READY
+static uint16_t Release_Ticks;                 //gate held open this long once it gets there
 
 
 /*******************************************************************************
@@ -118,13 +124,14 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
  switch (CurrentState) {
         case Init: // If current state is initial Psedudo State
             CurrentState = Turn;
+            Shot_Waiting = FALSE;
             break;
 
         case Turn: // in the first state, replace this with correct names
             if (Side == LEFT){
                 LeftWheelSpeed(300);
                 RightWheelSpeed(0);
-                if (Analog_TapeRead_L() < 450){
+                if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CLOSE)){
                     ES_Timer_InitTimer(TURN_2PT_TIMER, 10);   
                     CurrentState = Shooting;
                 } else {
@@ -135,7 +142,7 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
             else if (Side == RIGHT){
                 LeftWheelSpeed(0);
                 RightWheelSpeed(300);
-                if (Analog_TapeRead_R() < 450){
+                if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CLOSE)){
                     ES_Timer_InitTimer(TURN_2PT_TIMER, 10);
                     CurrentState = Shooting;
                 } else {
@@ -151,10 +158,13 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
                 if (ThisEvent.EventParam == TURN_2PT_TIMER){
                     LeftWheelSpeed(0);
                     RightWheelSpeed(0);
-                    ES_Timer_InitTimer(BALL_RELEASE_TIMER, 999);
-                    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
-                    Send_Ball();
-                    
+                    //hold the shot for the flywheels, at most a spin-up from rest
+                    if (Shot_Waiting || Flywheel_MayShoot()) {
+                        TwoPointer_Shoot();
+                    } else {
+                        Shot_Waiting = TRUE;
+                        ES_Timer_InitTimer(TURN_2PT_TIMER, FLYWHEEL_WAIT_TICKS);
+                    }
                 } 
                 if (ThisEvent.EventParam == BALL_RELEASE_TIMER){
                     //ES_Timer_InitTimer(TURN_1PT_TIMER, TURN_1PT_TICKS);
@@ -174,6 +184,14 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
                 }
                 
             }
+            if ((ThisEvent.EventType == FLYWHEEL_READY) && Shot_Waiting) {
+                ES_Timer_StopTimer(TURN_2PT_TIMER);
+                TwoPointer_Shoot();
+            }
+            //the gate is open, hold it there while the ball goes through
+            if ((ThisEvent.EventType == TURNSTILE_ARRIVED) && (ThisEvent.EventParam == TURNSTILE_SEND)) {
+                ES_Timer_InitTimer(BALL_RELEASE_TIMER, Release_Ticks);
+            }
             break;
         case Turn_Back:
             if (Side == LEFT){
@@ -186,6 +204,10 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
             }
             
             if (ThisEvent.EventType == ES_TIMEOUT){ 
+                //held open to the end of the shot, it can run out after SHOOT_TIMER
+                if (ThisEvent.EventParam == BALL_RELEASE_TIMER){
+                    Stop_Ball();
+                }
                 if (ThisEvent.EventParam == TURN_2PT_TIMER){
                    ThisEvent.EventType = SHOOTING_2PT_DONE;  
                     CurrentState = Init;
@@ -205,3 +227,16 @@ ES_Event RunTwoPointerSubHSM(ES_Event ThisEvent)
  * PRIVATE FUNCTIONS                                                           *
  ******************************************************************************/
 
+/**
+ * @Function TwoPointer_Shoot(void)
+ * @return None
+ * @brief Releases the ball and starts the timer that ends the shot. The gate closes
+ *        Release_Ticks after TURNSTILE_ARRIVED says it is open. */
+static void TwoPointer_Shoot(void)
+{
+    Shot_Waiting = FALSE;
+    Release_Ticks = 999 - TURNSTILE_MOVE_MS;
+    ES_Timer_InitTimer(SHOOT_TIMER, SHOOT_TICKS);
+    Send_Ball();
+    Flywheel_Shot();
+}
@@ -0,0 +1,349 @@
+/*
+ * File: WallController.c
+ *
+ * PID on the lateral error from WallEstimator. The heading error stands in for the
+ * derivative term: at a steady forward speed it is proportional to the rate of change
+ * of the distance, and it is measured directly instead of differencing a noisy signal.
+ * A positive turn steers toward the wall.
+ *
+ * The WALLCONTROLLER_SIM harness at the bottom builds on a PC and compares the
+ * controller against the old Follow_Wall/Align_F bang-bang on a simple drive model:
+ *     gcc -DWALLCONTROLLER_SIM WallController.c -o wallsim -lm
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#ifndef WALLCONTROLLER_SIM
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "WallController.h"
+#include "WallEstimator.h"
+#include "Motor_Driver.h"
+#include "Params.h"
+#include "BdayFSM.h"
+#else
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#endif
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define WALL_GAIN_SCALE 16      //gains are in 1/16ths
+#define WALL_TURN_LIMIT 500     //largest difference from the base speed, PWM
+#define WALL_SEEK_TURN 300      //turn toward the wall while the estimate is not valid
+#define WALL_MAX_WHEEL 1000
+
+/*******************************************************************************
+ * MODULE TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    int16_t Kp;
+    int16_t Ki;
+    int16_t Kd;
+    int16_t Limit;          //output limit, PWM
+    int32_t Integral;       //mm summed over control periods
+} WallPID_t;
+
+/*******************************************************************************
+ * PRIVATE FUNCTION PROTOTYPES                                                 *
+ ******************************************************************************/
+
+static int16_t WallController_Step(WallPID_t *Pid, int16_t Error, int16_t Rate);
+static int16_t WallController_Clamp(int32_t Value, int16_t Limit);
+
+#ifndef WALLCONTROLLER_SIM
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static uint8_t MyPriority;
+static WallPID_t Pid;
+static unsigned char FollowSide;
+static unsigned char Enabled = FALSE;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t InitWallController(uint8_t Priority)
+{
+    ES_Event ThisEvent;
+
+    MyPriority = Priority;
+    ThisEvent.EventType = ES_INIT;
+    if (ES_PostToService(MyPriority, ThisEvent) == TRUE) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+uint8_t PostWallController(ES_Event ThisEvent)
+{
+    return ES_PostToService(MyPriority, ThisEvent);
+}
+
+ES_Event RunWallController(ES_Event ThisEvent)
+{
+    ES_Event ReturnEvent;
+    WallEstimate_t Estimate;
+    int16_t Turn;
+    int16_t Base;
+
+    ReturnEvent.EventType = ES_NO_EVENT;
+
+    switch (ThisEvent.EventType) {
+    case ES_INIT:
+        WallEstimator_Subscribe(PostWallController);
+        break;
+
+    case WALL_ESTIMATE:
+        if (!Enabled) {
+            break;
+        }
+        WallEstimator_Get(FollowSide, &Estimate);
+        if (Estimate.Valid) {
+            Turn = WallController_Step(&Pid, Estimate.Distance - Params_Get(PARAM_WALL_DISTANCE), Estimate.Heading);
+        } else {
+            Pid.Integral = 0;
+            Turn = WALL_SEEK_TURN;
+        }
+        //the wheel on the far side of the wall speeds up to turn toward it
+        if (FollowSide == LEFT) {
+            Turn = -Turn;
+        }
+        Base = Params_Get(PARAM_WALL_SPEED);
+        Drive_SetWheels(WallController_Clamp((int32_t) Base + Turn, WALL_MAX_WHEEL),
+                WallController_Clamp((int32_t) Base - Turn, WALL_MAX_WHEEL));
+        break;
+
+    default:
+        break;
+    }
+    return ReturnEvent;
+}
+
+char WallController_Enable(unsigned char Side)
+{
+    if ((Side != LEFT) && (Side != RIGHT)) {
+        return ERROR;
+    }
+    Pid.Kp = Params_Get(PARAM_WALL_KP);
+    Pid.Ki = Params_Get(PARAM_WALL_KI);
+    Pid.Kd = Params_Get(PARAM_WALL_KD);
+    Pid.Limit = WALL_TURN_LIMIT;
+    Pid.Integral = 0;
+    FollowSide = Side;
+    Enabled = TRUE;
+    return SUCCESS;
+}
+
+void WallController_Disable(void)
+{
+    Enabled = FALSE;
+}
+
+unsigned char WallController_IsEnabled(void)
+{
+    return Enabled;
+}
+#endif
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+/**
+ * @Function WallController_Step(WallPID_t *Pid, int16_t Error, int16_t Rate)
+ * @param Pid - gains and integrator state
+ * @param Error - mm, positive when too far from the wall
+ * @param Rate - heading error in mrad, positive when pointing away from the wall
+ * @return turn command in PWM, limited to +/- Pid->Limit
+ * @brief The integrator only takes the new error while the output is inside the
+ *        limits, or when the error drives it back in, so it does not wind up while
+ *        the robot is pulled far off the wall */
+static int16_t WallController_Step(WallPID_t *Pid, int16_t Error, int16_t Rate)
+{
+    int32_t Integral = Pid->Integral + Error;
+    int32_t Output;
+
+    Output = ((int32_t) Pid->Kp * Error + (int32_t) Pid->Kd * Rate + (int32_t) Pid->Ki * Integral) / WALL_GAIN_SCALE;
+    if (Output > Pid->Limit) {
+        Output = Pid->Limit;
+        if (Error < 0) {
+            Pid->Integral = Integral;
+        }
+    } else if (Output < -Pid->Limit) {
+        Output = -Pid->Limit;
+        if (Error > 0) {
+            Pid->Integral = Integral;
+        }
+    } else {
+        Pid->Integral = Integral;
+    }
+    return Output;
+}
+
+static int16_t WallController_Clamp(int32_t Value, int16_t Limit)
+{
+    if (Value > Limit) {
+        return Limit;
+    }
+    if (Value < -Limit) {
+        return -Limit;
+    }
+    return Value;
+}
+
+#ifdef WALLCONTROLLER_SIM
+/*
+ * Differential drive along a straight wall on the right. The wheels follow their
+ * command with a first order lag, and the sensors see the wall at the front and back
+ * with some noise. Bang-bang switches on the front sensor alone at the 3 ms event
+ * check rate, the same way Follow_Wall and Align_F do: away from the wall (400/1000)
+ * until FAR, then toward it (1000/400) until INRANGE. The PID runs every 10 ms on the
+ * filtered distance and heading the way WallEstimator computes them, at the old
+ * average speed of 700 and at the default PARAM_WALL_SPEED of 800.
+ */
+#define SIM_WALL_LENGTH_MM 2400.0
+#define SIM_TIMEOUT_S 20.0
+#define SIM_STEP_S 0.001
+#define SIM_MM_PER_S_PER_PWM 0.5
+#define SIM_WHEELBASE_MM 220.0
+#define SIM_SENSOR_SPACING_MM 200.0
+#define SIM_MOTOR_TAU_S 0.08
+#define SIM_NOISE_MM 4
+#define SIM_INRANGE_MM 50.0
+#define SIM_FAR_MM 150.0
+#define SIM_SETPOINT_MM 100
+
+typedef struct {
+    const char *Name;
+    double Distance;        //mm, start distance from the wall
+    double Heading;         //rad, positive pointing away from the wall
+} SimStart_t;
+
+typedef struct {
+    double Time;
+    double RmsError;
+    double MaxError;
+    unsigned int Reversals;
+    unsigned int Contacts;
+} SimResult_t;
+
+static unsigned long SimSeed;
+
+static double SimNoise(void)
+{
+    SimSeed = SimSeed * 1103515245UL + 12345UL;
+    return (double) ((long) ((SimSeed >> 16) % (2 * SIM_NOISE_MM + 1)) - SIM_NOISE_MM);
+}
+
+static SimResult_t Simulate(const SimStart_t *Start, int16_t PidBase)
+{
+    SimResult_t Result = {0, 0, 0, 0, 0};
+    WallPID_t Sim = {96, 1, 48, WALL_TURN_LIMIT, 0};
+    double X = 0, Y = Start->Distance, Theta = Start->Heading;
+    double Left = 0, Right = 0;         //mm/s
+    double LeftCommand = 700, RightCommand = 700;
+    double Front, Back, FilteredFront = Y, FilteredBack = Y;
+    double SumSquares = 0;
+    double Error;
+    unsigned long Steps = 0;
+    int Toward = 0;
+    int LastSwing = 0;
+    int Touching = 0;
+    int16_t Turn;
+
+    SimSeed = 118;
+    while ((X < SIM_WALL_LENGTH_MM) && (Result.Time < SIM_TIMEOUT_S)) {
+        Front = Y + (SIM_SENSOR_SPACING_MM / 2) * sin(Theta) + SimNoise();
+        Back = Y - (SIM_SENSOR_SPACING_MM / 2) * sin(Theta) + SimNoise();
+        if (PidBase && ((Steps % 10) == 0)) {
+            FilteredFront += (Front - FilteredFront) / 4;
+            FilteredBack += (Back - FilteredBack) / 4;
+            if ((FilteredFront < SIM_FAR_MM) && (FilteredBack < SIM_FAR_MM)) {
+                Turn = WallController_Step(&Sim, (int16_t) ((FilteredFront + FilteredBack) / 2) - SIM_SETPOINT_MM,
+                        (int16_t) ((FilteredFront - FilteredBack) * 1000 / SIM_SENSOR_SPACING_MM));
+            } else {
+                Sim.Integral = 0;
+                Turn = WALL_SEEK_TURN;
+            }
+            LeftCommand = WallController_Clamp(PidBase + Turn, WALL_MAX_WHEEL);
+            RightCommand = WallController_Clamp(PidBase - Turn, WALL_MAX_WHEEL);
+            //a reversal is a swing as large as the bang-bang one, 300 either side
+            if ((Turn >= WALL_SEEK_TURN) && (LastSwing <= 0)) {
+                Result.Reversals += (LastSwing != 0);
+                LastSwing = 1;
+            } else if ((Turn <= -WALL_SEEK_TURN) && (LastSwing >= 0)) {
+                Result.Reversals += (LastSwing != 0);
+                LastSwing = -1;
+            }
+        } else if (!PidBase && ((Steps % 3) == 0)) {
+            if (!Toward && (Front > SIM_FAR_MM)) {
+                Toward = 1;
+                Result.Reversals++;
+            } else if (Toward && (Front < SIM_INRANGE_MM)) {
+                Toward = 0;
+                Result.Reversals++;
+            }
+            LeftCommand = Toward ? 1000 : 400;
+            RightCommand = Toward ? 400 : 1000;
+        }
+        Left += (LeftCommand * SIM_MM_PER_S_PER_PWM - Left) * SIM_STEP_S / SIM_MOTOR_TAU_S;
+        Right += (RightCommand * SIM_MM_PER_S_PER_PWM - Right) * SIM_STEP_S / SIM_MOTOR_TAU_S;
+        Theta += (Right - Left) / SIM_WHEELBASE_MM * SIM_STEP_S;
+        X += (Left + Right) / 2 * cos(Theta) * SIM_STEP_S;
+        Y += (Left + Right) / 2 * sin(Theta) * SIM_STEP_S;
+        if (Y - (SIM_SENSOR_SPACING_MM / 2) * fabs(sin(Theta)) < 0) {
+            //scraping along the wall, it stops the robot moving any closer
+            Y = (SIM_SENSOR_SPACING_MM / 2) * fabs(sin(Theta));
+            if (!Touching) {
+                Result.Contacts++;
+            }
+            Touching = 1;
+        } else {
+            Touching = 0;
+        }
+        Error = Y - SIM_SETPOINT_MM;
+        SumSquares += Error * Error;
+        if (fabs(Error) > Result.MaxError) {
+            Result.MaxError = fabs(Error);
+        }
+        Steps++;
+        Result.Time = Steps * SIM_STEP_S;
+    }
+    Result.RmsError = sqrt(SumSquares / Steps);
+    return Result;
+}
+
+int main(void)
+{
+    static const SimStart_t Starts[] = {
+        {"aligned", SIM_SETPOINT_MM, 0.0},
+        {"after pivot", 130.0, -0.15},
+        {"nose out", 80.0, 0.25},
+    };
+    static const int16_t Controls[] = {0, 700, 800};
+    SimResult_t Result;
+    unsigned int i, j;
+
+    printf("%-12s %-9s %8s %8s %8s %9s %8s\n", "start", "control", "time s", "rms mm", "max mm", "reversals", "contacts");
+    for (i = 0; i < sizeof (Starts) / sizeof (Starts[0]); i++) {
+        for (j = 0; j < sizeof (Controls) / sizeof (Controls[0]); j++) {
+            Result = Simulate(&Starts[i], Controls[j]);
+            printf("%-12s %-9s %8.2f %8.1f %8.1f %9u %8u\n", Starts[i].Name,
+                    Controls[j] ? (Controls[j] == 700 ? "pid 700" : "pid 800") : "bang-bang",
+                    Result.Time, Result.RmsError, Result.MaxError, Result.Reversals, Result.Contacts);
+        }
+    }
+    return 0;
+}
+#endif
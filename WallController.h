@@ -0,0 +1,43 @@
+/*
+ * File: WallController.h
+ *
+ * Closed loop wall following. While enabled, the controller steers the drive wheels
+ * on every WALL_ESTIMATE from WallEstimator (10 ms). It holds PARAM_WALL_DISTANCE
+ * from the wall at PARAM_WALL_SPEED. BdayFSM only enables and disables it.
+ */
+
+#ifndef WallController_H
+#define WallController_H
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+uint8_t InitWallController(uint8_t Priority);
+
+uint8_t PostWallController(ES_Event ThisEvent);
+
+ES_Event RunWallController(ES_Event ThisEvent);
+
+/**
+ * @Function WallController_Enable(unsigned char Side)
+ * @param Side - LEFT or RIGHT, the side the wall is on
+ * @return SUCCESS or ERROR for a bad side
+ * @brief Loads the gains from Params, clears the integrator and starts driving the
+ *        wheels from the next estimate */
+char WallController_Enable(unsigned char Side);
+
+/**
+ * @Function WallController_Disable(void)
+ * @return None
+ * @brief Stops writing the wheels, they keep whatever speed was last set */
+void WallController_Disable(void);
+
+/**
+ * @Function WallController_IsEnabled(void)
+ * @return TRUE while the controller owns the wheels */
+unsigned char WallController_IsEnabled(void);
+
+#endif /* WallController_H */
@@ -0,0 +1,199 @@
+/*
+ * File: WallEstimator.c
+ *
+ * Each sensor reading is low pass filtered and turned into a distance with a piecewise
+ * linear curve through that sensor's own threshold table (AnalogTapeSensors), so the
+ * curve follows the boot calibration. The calibration only moves the thresholds in A/D
+ * counts, the distance each level sits at is PARAM_WALL_LEVEL_MM + level. Those default
+ * to nominal values that have NOT been measured. To measure them, power up in Tune
+ * (bumper held), send "w" with a wall at a ruler distance and move it until a sensor
+ * reads its threshold for a level, then store that distance with "p <id> <mm>".
+ */
+
+/*******************************************************************************
+ * MODULE #INCLUDE                                                             *
+ ******************************************************************************/
+
+#include "BOARD.h"
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "WallEstimator.h"
+#include "AnalogTapeSensors.h"
+#include "BdayFSM.h"
+#include "SensorHealth.h"
+#include "Params.h"
+#include <stdio.h>
+
+/*******************************************************************************
+ * MODULE #DEFINES                                                             *
+ ******************************************************************************/
+
+#define WALL_SENSOR_SPACING_MM 200  //front to back sensor along the side of the robot
+#define WALL_FILTER_SHIFT 2         //readings filtered with a 1/4 weight per update
+#define WALL_FILTER_FRACTION 4      //filtered readings are kept in Q4
+
+/*******************************************************************************
+ * PRIVATE FUNCTION PROTOTYPES                                                 *
+ ******************************************************************************/
+
+static int16_t WallEstimator_Distance(unsigned char Sensor, uint16_t Reading);
+
+/*******************************************************************************
+ * PRIVATE MODULE VARIABLES                                                    *
+ ******************************************************************************/
+
+static uint8_t MyPriority;
+
+//sensors for each side, indexed by RIGHT and LEFT
+static const unsigned char FrontSensor[2] = {ANALOG_TAPE_FR, ANALOG_TAPE_FL};
+static const unsigned char BackSensor[2] = {ANALOG_TAPE_R, ANALOG_TAPE_L};
+
+static uint32_t Filtered[NUM_ANALOG_TAPE];
+static WallEstimate_t Estimates[2];
+static uint8_t (*Subscriber)(ES_Event) = NULL;
+
+/*******************************************************************************
+ * PUBLIC FUNCTIONS                                                            *
+ ******************************************************************************/
+
+uint8_t InitWallEstimator(uint8_t Priority)
+{
+    ES_Event ThisEvent;
+
+    MyPriority = Priority;
+    ThisEvent.EventType = ES_INIT;
+    if (ES_PostToService(MyPriority, ThisEvent) == TRUE) {
+        return TRUE;
+    } else {
+        return FALSE;
+    }
+}
+
+uint8_t PostWallEstimator(ES_Event ThisEvent)
+{
+    return ES_PostToService(MyPriority, ThisEvent);
+}
+
+ES_Event RunWallEstimator(ES_Event ThisEvent)
+{
+    ES_Event ReturnEvent;
+    ES_Event Published;
+    int16_t Front, Back;
+    unsigned char i, Side;
+
+    ReturnEvent.EventType = ES_NO_EVENT;
+
+    switch (ThisEvent.EventType) {
+    case ES_INIT:
+        for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+            Filtered[i] = (uint32_t) Analog_TapeRead(i) << WALL_FILTER_FRACTION;
+        }
+        ES_Timer_InitTimer(WALL_ESTIMATE_TIMER, WALL_ESTIMATE_TICKS);
+        break;
+
+    case ES_TIMEOUT:
+        if (ThisEvent.EventParam != WALL_ESTIMATE_TIMER) {
+            break;
+        }
+        ES_Timer_InitTimer(WALL_ESTIMATE_TIMER, WALL_ESTIMATE_TICKS);
+        for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+            Filtered[i] += (((int32_t) Analog_TapeRead(i) << WALL_FILTER_FRACTION) - (int32_t) Filtered[i]) >> WALL_FILTER_SHIFT;
+        }
+        SensorHealth_Update();
+        Published.EventType = WALL_ESTIMATE;
+        Published.EventParam = 0;
+        for (Side = RIGHT; Side <= LEFT; Side++) {
+            Front = WallEstimator_Distance(FrontSensor[Side], Filtered[FrontSensor[Side]] >> WALL_FILTER_FRACTION);
+            Back = WallEstimator_Distance(BackSensor[Side], Filtered[BackSensor[Side]] >> WALL_FILTER_FRACTION);
+            //with one sensor of the pair faulted, hold the distance from the other and assume parallel
+            if (!SensorHealth_IsHealthy(FrontSensor[Side]) && !SensorHealth_IsHealthy(BackSensor[Side])) {
+                Front = -1;
+            } else if (!SensorHealth_IsHealthy(FrontSensor[Side])) {
+                Front = Back;
+            } else if (!SensorHealth_IsHealthy(BackSensor[Side])) {
+                Back = Front;
+            }
+            Estimates[Side].Valid = (Front >= 0) && (Back >= 0);
+            if (Estimates[Side].Valid) {
+                Estimates[Side].Distance = (Front + Back) / 2;
+                //small angle, the spacing is much larger than the distance change
+                Estimates[Side].Heading = ((int32_t) (Front - Back) * 1000) / WALL_SENSOR_SPACING_MM;
+                Published.EventParam |= (1 << Side);
+            }
+        }
+        if (Subscriber != NULL) {
+            Subscriber(Published);
+        }
+        break;
+
+    default:
+        break;
+    }
+    return ReturnEvent;
+}
+
+char WallEstimator_Get(unsigned char Side, WallEstimate_t *Estimate)
+{
+    if ((Side != LEFT) && (Side != RIGHT)) {
+        return ERROR;
+    }
+    *Estimate = Estimates[Side];
+    return SUCCESS;
+}
+
+void WallEstimator_Subscribe(uint8_t (*Post)(ES_Event))
+{
+    Subscriber = Post;
+}
+
+void WallEstimator_PrintDiagnostics(void)
+{
+    static const char * const Names[NUM_ANALOG_TAPE] = {"L", "R", "FL", "FR"};
+    unsigned char i, Level;
+
+    for (i = 0; i < NUM_ANALOG_TAPE; i++) {
+        printf("  %-2s reads %4u, thresholds", Names[i], (unsigned int) (Filtered[i] >> WALL_FILTER_FRACTION));
+        for (Level = TAPE_CONTACT; Level < NUM_TAPE_LEVELS; Level++) {
+            printf(" %4u", Analog_TapeGetThreshold(i, Level));
+        }
+        printf("\r\n");
+    }
+    printf("  levels at");
+    for (Level = TAPE_CONTACT; Level < NUM_TAPE_LEVELS; Level++) {
+        printf(" %d", Params_Get(PARAM_WALL_LEVEL_MM + Level));
+    }
+    printf(" mm, right %d mm %s, left %d mm %s\r\n",
+            Estimates[RIGHT].Distance, Estimates[RIGHT].Valid ? "valid" : "invalid",
+            Estimates[LEFT].Distance, Estimates[LEFT].Valid ? "valid" : "invalid");
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+/**
+ * @Function WallEstimator_Distance(unsigned char Sensor, uint16_t Reading)
+ * @param Sensor - ANALOG_TAPE_x
+ * @param Reading - filtered A/D counts
+ * @return mm from the wall, or -1 when the reading is beyond the far threshold
+ * @brief Interpolates between the sensor's thresholds, readings under the contact
+ *        threshold are scaled down towards 0 mm at 0 counts */
+static int16_t WallEstimator_Distance(unsigned char Sensor, uint16_t Reading)
+{
+    uint16_t Low = 0;
+    uint16_t High;
+    int16_t LowDistance = 0;
+    int16_t HighDistance;
+    unsigned char Level;
+
+    for (Level = TAPE_CONTACT; Level < NUM_TAPE_LEVELS; Level++) {
+        High = Analog_TapeGetThreshold(Sensor, Level);
+        HighDistance = Params_Get(PARAM_WALL_LEVEL_MM + Level);
+        if ((Reading <= High) && (High > Low)) {
+            return LowDistance + ((int32_t) (Reading - Low) * (HighDistance - LowDistance)) / (High - Low);
+        }
+        Low = High;
+        LowDistance = HighDistance;
+    }
+    return -1;
+}
@@ -0,0 +1,62 @@
+/*
+ * File: WallEstimator.h
+ *
+ * Service that fuses the front and back analog wall sensors on each side into a
+ * continuous distance and heading error. It runs every WALL_ESTIMATE_TICKS ms and
+ * posts WALL_ESTIMATE to its subscriber after each update.
+ */
+
+#ifndef WallEstimator_H
+#define WallEstimator_H
+
+#include "ES_Configure.h"   // defines ES_Event, INIT_EVENT, ENTRY_EVENT, and EXIT_EVENT
+
+/*******************************************************************************
+ * PUBLIC #DEFINES                                                             *
+ ******************************************************************************/
+
+#define WALL_ESTIMATE_TIMER 13
+#define WALL_ESTIMATE_TICKS 10
+
+/*******************************************************************************
+ * PUBLIC TYPEDEFS                                                             *
+ ******************************************************************************/
+
+typedef struct {
+    int16_t Distance;       //mm from the wall, mean of the front and back sensors
+    int16_t Heading;        //mrad, positive when the nose points away from the wall
+    uint8_t Valid;          //both sensors on the side see the wall, or the one left working
+} WallEstimate_t;
+
+/*******************************************************************************
+ * PUBLIC FUNCTION PROTOTYPES                                                  *
+ ******************************************************************************/
+
+uint8_t InitWallEstimator(uint8_t Priority);
+
+uint8_t PostWallEstimator(ES_Event ThisEvent);
+
+ES_Event RunWallEstimator(ES_Event ThisEvent);
+
+/**
+ * @Function WallEstimator_Get(unsigned char Side, WallEstimate_t *Estimate)
+ * @param Side - LEFT or RIGHT, as in BdayFSM.h
+ * @param Estimate - filled in with the latest estimate for that side
+ * @return SUCCESS or ERROR for a bad side */
+char WallEstimator_Get(unsigned char Side, WallEstimate_t *Estimate);
+
+/**
+ * @Function WallEstimator_Subscribe(uint8_t (*Post)(ES_Event))
+ * @param Post - post function that gets WALL_ESTIMATE after every update, NULL to stop
+ * @return None
+ * @brief EventParam of WALL_ESTIMATE has bit LEFT/RIGHT set for each valid side */
+void WallEstimator_Subscribe(uint8_t (*Post)(ES_Event));
+
+/**
+ * @Function WallEstimator_PrintDiagnostics(void)
+ * @return None
+ * @brief Prints each sensor's filtered reading against its thresholds, the level
+ *        distances and both estimates, for measuring PARAM_WALL_LEVEL_MM */
+void WallEstimator_PrintDiagnostics(void);
+
+#endif /* WallEstimator_H */
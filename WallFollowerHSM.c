@@ -273,6 +273,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
     switch (ThisEvent.EventType){    
     case (ES_TIMEOUT):
             if (ThisEvent.EventParam == TAPE_SERVICE_TIMER){
+                IO_PortsTakeSnapshot();
                 CheckDigitalTape();
                 CheckAnalogTape();
                 CheckBumpers();
@@ -321,12 +322,12 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                 RightFlyWheelSpeed(-300);
                 
                 if (Side == RIGHT){
-                    if (Analog_TapeRead_FR() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_FR, TAPE_CONTACT)){
                         CurrentState = Pivot;
                         RightWheelSpeed(300);
                         LeftWheelSpeed(0);
                         
-                        if (Analog_TapeRead_L() < 250){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CONTACT)){
                             CurrentState = Follow_Wall;
                             RightWheelSpeed(500);
                             LeftWheelSpeed(300);
@@ -334,12 +335,12 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     }
                 } 
                 else if (Side == LEFT) {
-                    if (Analog_TapeRead_FL() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_FL, TAPE_CONTACT)){
                         CurrentState = Pivot;
                         RightWheelSpeed(0);
                         LeftWheelSpeed(300);
                         
-                        if (Analog_TapeRead_L() < 250){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CONTACT)){
                             CurrentState = Follow_Wall;
                             RightWheelSpeed(300);
                             LeftWheelSpeed(500);
@@ -361,7 +362,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     RightWheelSpeed(300);
                     LeftWheelSpeed(0);
                     
-                    if (Analog_TapeRead_R() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CONTACT)){
                         CurrentState = Follow_Wall;
                         RightWheelSpeed(500);
                         LeftWheelSpeed(300);
@@ -378,7 +379,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     RightWheelSpeed(0);
                     LeftWheelSpeed(300);
                     
-                    if (Analog_TapeRead_L() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CONTACT)){
                         CurrentState = Follow_Wall;
                         RightWheelSpeed(300);
                         LeftWheelSpeed(500);
@@ -551,7 +552,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
             if (ThisEvent.EventType == SHOOTING_2PT_DONE){
                 
                 if (Side == RIGHT){
-                    if (Analog_TapeRead_R() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_R, TAPE_CONTACT)){
                         RightWheelSpeed(-500);
                         LeftWheelSpeed(-300); 
                         CurrentState = Reverse_Wall;
@@ -561,7 +562,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                         CurrentState = Align_R; 
                     }
                 } else if (Side == LEFT){
-                    if (Analog_TapeRead_L() < 250){
+                    if (Analog_TapeIsWithin(ANALOG_TAPE_L, TAPE_CONTACT)){
                         RightWheelSpeed(-300);
                         LeftWheelSpeed(-500); 
                         CurrentState = Reverse_Wall;
@@ -611,7 +612,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                     TapeFlag = FALSE;
 
                     if (Side == RIGHT){
-                        if (Analog_TapeRead_FR() < 250){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_FR, TAPE_CONTACT)){
                             RightWheelSpeed(500);
                             LeftWheelSpeed(300);
                         } else {
@@ -619,7 +620,7 @@ ES_Event RunBdayFSM(ES_Event ThisEvent)
                             LeftWheelSpeed(500);
                         }
                     } else if (Side == LEFT){
-                        if (Analog_TapeRead_FL() < 250){
+                        if (Analog_TapeIsWithin(ANALOG_TAPE_FL, TAPE_CONTACT)){
                             RightWheelSpeed(300);
                             LeftWheelSpeed(500);
                         } else {
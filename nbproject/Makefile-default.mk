@@ -57,17 +57,17 @@ OBJECTDIR=build/${CND_CONF}/${IMAGE_TYPE}
 DISTDIR=dist/${CND_CONF}/${IMAGE_TYPE}
 
 # Source Files Quoted if spaced
-SOURCEFILES_QUOTED_IF_SPACED=AD.c BOARD.c ES_CheckEvents.c ES_Framework.c ES_KeyboardInput.c ES_PostList.c ES_Queue.c ES_Timers.c IO_Ports.c LED.c pwm.c RC_Servo.c serial.c timers.c BCEventChecker.c DigitalTapeSensors.c TESTEventService.c AnalogTapeSensors.c Motor_Driver.c Servo.c BumperSensor.c TrackWire.c Beacon.c OnePointerSubHSM.c TwoPointerSubHSM.c ThreePointerSubHSM.c OPBSubHSM.c BDayFSM.c
+SOURCEFILES_QUOTED_IF_SPACED=AD.c BOARD.c ES_CheckEvents.c ES_Framework.c ES_KeyboardInput.c ES_PostList.c ES_Queue.c ES_Timers.c IO_Ports.c LED.c pwm.c RC_Servo.c serial.c timers.c BCEventChecker.c DigitalTapeSensors.c TESTEventService.c AnalogTapeSensors.c Motor_Driver.c Servo.c BumperSensor.c TrackWire.c Beacon.c OnePointerSubHSM.c TwoPointerSubHSM.c ThreePointerSubHSM.c OPBSubHSM.c BDayFSM.c Params.c WallEstimator.c WallController.c Battery.c SensorHealth.c Flywheel.c
 
 # Object Files Quoted if spaced
-OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/AD.o ${OBJECTDIR}/BOARD.o ${OBJECTDIR}/ES_CheckEvents.o ${OBJECTDIR}/ES_Framework.o ${OBJECTDIR}/ES_KeyboardInput.o ${OBJECTDIR}/ES_PostList.o ${OBJECTDIR}/ES_Queue.o ${OBJECTDIR}/ES_Timers.o ${OBJECTDIR}/IO_Ports.o ${OBJECTDIR}/LED.o ${OBJECTDIR}/pwm.o ${OBJECTDIR}/RC_Servo.o ${OBJECTDIR}/serial.o ${OBJECTDIR}/timers.o ${OBJECTDIR}/BCEventChecker.o ${OBJECTDIR}/DigitalTapeSensors.o ${OBJECTDIR}/TESTEventService.o ${OBJECTDIR}/AnalogTapeSensors.o ${OBJECTDIR}/Motor_Driver.o ${OBJECTDIR}/Servo.o ${OBJECTDIR}/BumperSensor.o ${OBJECTDIR}/TrackWire.o ${OBJECTDIR}/Beacon.o ${OBJECTDIR}/OnePointerSubHSM.o ${OBJECTDIR}/TwoPointerSubHSM.o ${OBJECTDIR}/ThreePointerSubHSM.o ${OBJECTDIR}/OPBSubHSM.o ${OBJECTDIR}/BDayFSM.o
-POSSIBLE_DEPFILES=${OBJECTDIR}/AD.o.d ${OBJECTDIR}/BOARD.o.d ${OBJECTDIR}/ES_CheckEvents.o.d ${OBJECTDIR}/ES_Framework.o.d ${OBJECTDIR}/ES_KeyboardInput.o.d ${OBJECTDIR}/ES_PostList.o.d ${OBJECTDIR}/ES_Queue.o.d ${OBJECTDIR}/ES_Timers.o.d ${OBJECTDIR}/IO_Ports.o.d ${OBJECTDIR}/LED.o.d ${OBJECTDIR}/pwm.o.d ${OBJECTDIR}/RC_Servo.o.d ${OBJECTDIR}/serial.o.d ${OBJECTDIR}/timers.o.d ${OBJECTDIR}/BCEventChecker.o.d ${OBJECTDIR}/DigitalTapeSensors.o.d ${OBJECTDIR}/TESTEventService.o.d ${OBJECTDIR}/AnalogTapeSensors.o.d ${OBJECTDIR}/Motor_Driver.o.d ${OBJECTDIR}/Servo.o.d ${OBJECTDIR}/BumperSensor.o.d ${OBJECTDIR}/TrackWire.o.d ${OBJECTDIR}/Beacon.o.d ${OBJECTDIR}/OnePointerSubHSM.o.d ${OBJECTDIR}/TwoPointerSubHSM.o.d ${OBJECTDIR}/ThreePointerSubHSM.o.d ${OBJECTDIR}/OPBSubHSM.o.d ${OBJECTDIR}/BDayFSM.o.d
+OBJECTFILES_QUOTED_IF_SPACED=${OBJECTDIR}/AD.o ${OBJECTDIR}/BOARD.o ${OBJECTDIR}/ES_CheckEvents.o ${OBJECTDIR}/ES_Framework.o ${OBJECTDIR}/ES_KeyboardInput.o ${OBJECTDIR}/ES_PostList.o ${OBJECTDIR}/ES_Queue.o ${OBJECTDIR}/ES_Timers.o ${OBJECTDIR}/IO_Ports.o ${OBJECTDIR}/LED.o ${OBJECTDIR}/pwm.o ${OBJECTDIR}/RC_Servo.o ${OBJECTDIR}/serial.o ${OBJECTDIR}/timers.o ${OBJECTDIR}/BCEventChecker.o ${OBJECTDIR}/DigitalTapeSensors.o ${OBJECTDIR}/TESTEventService.o ${OBJECTDIR}/AnalogTapeSensors.o ${OBJECTDIR}/Motor_Driver.o ${OBJECTDIR}/Servo.o ${OBJECTDIR}/BumperSensor.o ${OBJECTDIR}/TrackWire.o ${OBJECTDIR}/Beacon.o ${OBJECTDIR}/OnePointerSubHSM.o ${OBJECTDIR}/TwoPointerSubHSM.o ${OBJECTDIR}/ThreePointerSubHSM.o ${OBJECTDIR}/OPBSubHSM.o ${OBJECTDIR}/BDayFSM.o ${OBJECTDIR}/Params.o ${OBJECTDIR}/WallEstimator.o ${OBJECTDIR}/WallController.o ${OBJECTDIR}/Battery.o ${OBJECTDIR}/SensorHealth.o ${OBJECTDIR}/Flywheel.o
+POSSIBLE_DEPFILES=${OBJECTDIR}/AD.o.d ${OBJECTDIR}/BOARD.o.d ${OBJECTDIR}/ES_CheckEvents.o.d ${OBJECTDIR}/ES_Framework.o.d ${OBJECTDIR}/ES_KeyboardInput.o.d ${OBJECTDIR}/ES_PostList.o.d ${OBJECTDIR}/ES_Queue.o.d ${OBJECTDIR}/ES_Timers.o.d ${OBJECTDIR}/IO_Ports.o.d ${OBJECTDIR}/LED.o.d ${OBJECTDIR}/pwm.o.d ${OBJECTDIR}/RC_Servo.o.d ${OBJECTDIR}/serial.o.d ${OBJECTDIR}/timers.o.d ${OBJECTDIR}/BCEventChecker.o.d ${OBJECTDIR}/DigitalTapeSensors.o.d ${OBJECTDIR}/TESTEventService.o.d ${OBJECTDIR}/AnalogTapeSensors.o.d ${OBJECTDIR}/Motor_Driver.o.d ${OBJECTDIR}/Servo.o.d ${OBJECTDIR}/BumperSensor.o.d ${OBJECTDIR}/TrackWire.o.d ${OBJECTDIR}/Beacon.o.d ${OBJECTDIR}/OnePointerSubHSM.o.d ${OBJECTDIR}/TwoPointerSubHSM.o.d ${OBJECTDIR}/ThreePointerSubHSM.o.d ${OBJECTDIR}/OPBSubHSM.o.d ${OBJECTDIR}/BDayFSM.o.d ${OBJECTDIR}/Params.o.d ${OBJECTDIR}/WallEstimator.o.d ${OBJECTDIR}/WallController.o.d ${OBJECTDIR}/Battery.o.d ${OBJECTDIR}/SensorHealth.o.d ${OBJECTDIR}/Flywheel.o.d
 
 # Object Files
-OBJECTFILES=${OBJECTDIR}/AD.o ${OBJECTDIR}/BOARD.o ${OBJECTDIR}/ES_CheckEvents.o ${OBJECTDIR}/ES_Framework.o ${OBJECTDIR}/ES_KeyboardInput.o ${OBJECTDIR}/ES_PostList.o ${OBJECTDIR}/ES_Queue.o ${OBJECTDIR}/ES_Timers.o ${OBJECTDIR}/IO_Ports.o ${OBJECTDIR}/LED.o ${OBJECTDIR}/pwm.o ${OBJECTDIR}/RC_Servo.o ${OBJECTDIR}/serial.o ${OBJECTDIR}/timers.o ${OBJECTDIR}/BCEventChecker.o ${OBJECTDIR}/DigitalTapeSensors.o ${OBJECTDIR}/TESTEventService.o ${OBJECTDIR}/AnalogTapeSensors.o ${OBJECTDIR}/Motor_Driver.o ${OBJECTDIR}/Servo.o ${OBJECTDIR}/BumperSensor.o ${OBJECTDIR}/TrackWire.o ${OBJECTDIR}/Beacon.o ${OBJECTDIR}/OnePointerSubHSM.o ${OBJECTDIR}/TwoPointerSubHSM.o ${OBJECTDIR}/ThreePointerSubHSM.o ${OBJECTDIR}/OPBSubHSM.o ${OBJECTDIR}/BDayFSM.o
+OBJECTFILES=${OBJECTDIR}/AD.o ${OBJECTDIR}/BOARD.o ${OBJECTDIR}/ES_CheckEvents.o ${OBJECTDIR}/ES_Framework.o ${OBJECTDIR}/ES_KeyboardInput.o ${OBJECTDIR}/ES_PostList.o ${OBJECTDIR}/ES_Queue.o ${OBJECTDIR}/ES_Timers.o ${OBJECTDIR}/IO_Ports.o ${OBJECTDIR}/LED.o ${OBJECTDIR}/pwm.o ${OBJECTDIR}/RC_Servo.o ${OBJECTDIR}/serial.o ${OBJECTDIR}/timers.o ${OBJECTDIR}/BCEventChecker.o ${OBJECTDIR}/DigitalTapeSensors.o ${OBJECTDIR}/TESTEventService.o ${OBJECTDIR}/AnalogTapeSensors.o ${OBJECTDIR}/Motor_Driver.o ${OBJECTDIR}/Servo.o ${OBJECTDIR}/BumperSensor.o ${OBJECTDIR}/TrackWire.o ${OBJECTDIR}/Beacon.o ${OBJECTDIR}/OnePointerSubHSM.o ${OBJECTDIR}/TwoPointerSubHSM.o ${OBJECTDIR}/ThreePointerSubHSM.o ${OBJECTDIR}/OPBSubHSM.o ${OBJECTDIR}/BDayFSM.o ${OBJECTDIR}/Params.o ${OBJECTDIR}/WallEstimator.o ${OBJECTDIR}/WallController.o ${OBJECTDIR}/Battery.o ${OBJECTDIR}/SensorHealth.o ${OBJECTDIR}/Flywheel.o
 
 # Source Files
-SOURCEFILES=AD.c BOARD.c ES_CheckEvents.c ES_Framework.c ES_KeyboardInput.c ES_PostList.c ES_Queue.c ES_Timers.c IO_Ports.c LED.c pwm.c RC_Servo.c serial.c timers.c BCEventChecker.c DigitalTapeSensors.c TESTEventService.c AnalogTapeSensors.c Motor_Driver.c Servo.c BumperSensor.c TrackWire.c Beacon.c OnePointerSubHSM.c TwoPointerSubHSM.c ThreePointerSubHSM.c OPBSubHSM.c BDayFSM.c
+SOURCEFILES=AD.c BOARD.c ES_CheckEvents.c ES_Framework.c ES_KeyboardInput.c ES_PostList.c ES_Queue.c ES_Timers.c IO_Ports.c LED.c pwm.c RC_Servo.c serial.c timers.c BCEventChecker.c DigitalTapeSensors.c TESTEventService.c AnalogTapeSensors.c Motor_Driver.c Servo.c BumperSensor.c TrackWire.c Beacon.c OnePointerSubHSM.c TwoPointerSubHSM.c ThreePointerSubHSM.c OPBSubHSM.c BDayFSM.c Params.c WallEstimator.c WallController.c Battery.c SensorHealth.c Flywheel.c
 
 
 
@@ -275,6 +275,42 @@ ${OBJECTDIR}/BDayFSM.o: BDayFSM.c  .generated_files/flags/default/7508591e44d9d4
 	@${RM} ${OBJECTDIR}/BDayFSM.o 
 	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/BDayFSM.o.d" -o ${OBJECTDIR}/BDayFSM.o BDayFSM.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
 	
+${OBJECTDIR}/Params.o: Params.c  .generated_files/flags/default/a91154b0e796c3a59ffa1842da5c8090045f3806 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Params.o.d 
+	@${RM} ${OBJECTDIR}/Params.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Params.o.d" -o ${OBJECTDIR}/Params.o Params.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/WallEstimator.o: WallEstimator.c  .generated_files/flags/default/f7764eef72b3f7f8e009cbe01e958804f24c1526 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/WallEstimator.o.d 
+	@${RM} ${OBJECTDIR}/WallEstimator.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/WallEstimator.o.d" -o ${OBJECTDIR}/WallEstimator.o WallEstimator.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/WallController.o: WallController.c  .generated_files/flags/default/861dacb4c548d9b1ec979c7a6e5148babb870c00 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/WallController.o.d 
+	@${RM} ${OBJECTDIR}/WallController.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/WallController.o.d" -o ${OBJECTDIR}/WallController.o WallController.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/Battery.o: Battery.c  .generated_files/flags/default/43e22b9994de83477f6f690591cbbeae4b537b9e .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Battery.o.d 
+	@${RM} ${OBJECTDIR}/Battery.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Battery.o.d" -o ${OBJECTDIR}/Battery.o Battery.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/SensorHealth.o: SensorHealth.c  .generated_files/flags/default/540818691cf77659d8d475401ada86e6be233e0f .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/SensorHealth.o.d 
+	@${RM} ${OBJECTDIR}/SensorHealth.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/SensorHealth.o.d" -o ${OBJECTDIR}/SensorHealth.o SensorHealth.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/Flywheel.o: Flywheel.c  .generated_files/flags/default/401120ceecf345485b717c656b44cf8393268606 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Flywheel.o.d 
+	@${RM} ${OBJECTDIR}/Flywheel.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE) -g -D__DEBUG   -fframe-base-loclist  -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Flywheel.o.d" -o ${OBJECTDIR}/Flywheel.o Flywheel.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
 else
 ${OBJECTDIR}/AD.o: AD.c  .generated_files/flags/default/eae56921d79dea912934b887c52051751efc954a .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
 	@${MKDIR} "${OBJECTDIR}" 
@@ -444,6 +480,42 @@ ${OBJECTDIR}/BDayFSM.o: BDayFSM.c  .generated_files/flags/default/b50549ffa70716
 	@${RM} ${OBJECTDIR}/BDayFSM.o 
 	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/BDayFSM.o.d" -o ${OBJECTDIR}/BDayFSM.o BDayFSM.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
 	
+${OBJECTDIR}/Params.o: Params.c  .generated_files/flags/default/c9954066c248bf6f6fab432d137c8bf7b8b4fd11 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Params.o.d 
+	@${RM} ${OBJECTDIR}/Params.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Params.o.d" -o ${OBJECTDIR}/Params.o Params.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/WallEstimator.o: WallEstimator.c  .generated_files/flags/default/cf5380deb476ae7c2503bb6187f1909b423a043e .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/WallEstimator.o.d 
+	@${RM} ${OBJECTDIR}/WallEstimator.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/WallEstimator.o.d" -o ${OBJECTDIR}/WallEstimator.o WallEstimator.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/WallController.o: WallController.c  .generated_files/flags/default/82ba010c6d2a3ea2c9a3ce4154ee6e000ebf2b42 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/WallController.o.d 
+	@${RM} ${OBJECTDIR}/WallController.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/WallController.o.d" -o ${OBJECTDIR}/WallController.o WallController.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/Battery.o: Battery.c  .generated_files/flags/default/b4142943eeeb49967bbddefda067546b7cec4ec0 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Battery.o.d 
+	@${RM} ${OBJECTDIR}/Battery.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Battery.o.d" -o ${OBJECTDIR}/Battery.o Battery.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/SensorHealth.o: SensorHealth.c  .generated_files/flags/default/7167a648a8c70d13734c2d10583715f164e3be02 .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/SensorHealth.o.d 
+	@${RM} ${OBJECTDIR}/SensorHealth.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/SensorHealth.o.d" -o ${OBJECTDIR}/SensorHealth.o SensorHealth.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
+${OBJECTDIR}/Flywheel.o: Flywheel.c  .generated_files/flags/default/9e8c1a3ad9deef691d4269e1ef9d668ff82815ea .generated_files/flags/default/87483c345429186c5999dcd95309ab66555f8ca8
+	@${MKDIR} "${OBJECTDIR}" 
+	@${RM} ${OBJECTDIR}/Flywheel.o.d 
+	@${RM} ${OBJECTDIR}/Flywheel.o 
+	${MP_CC}  $(MP_EXTRA_CC_PRE)  -g -x c -c -mprocessor=$(MP_PROCESSOR_OPTION)  -fno-common -MP -MMD -MF "${OBJECTDIR}/Flywheel.o.d" -o ${OBJECTDIR}/Flywheel.o Flywheel.c    -DXPRJ_default=$(CND_CONF)  -legacy-libc  $(COMPARISON_BUILD)  -mdfp="${DFP_DIR}"  
+	
 endif
 
 # ------------------------------------------------------------------------------------
@@ -7,6 +7,7 @@
 
 #include <xc.h>
 #include "BOARD.h"
+#include <sys/attribs.h> //needed to use an interrupt
 
 #include "pwm.h"
 #include <stdio.h>
@@ -31,9 +32,33 @@
 #endif
 
 #define ALLPWMPINS (PWM_PORTZ06|PWM_PORTY12|PWM_PORTY10|PWM_PORTY04|PWM_PORTX11)
-#define NUM_PWM_CHANNELS 5
 
+//OCxRS counts for a duty cycle, DutyScale is the timer period / MAX_PWM in Q16
+#define DUTY_SCALE_SHIFT 16
+#define SCALE_DUTY(Duty, Timer) (((Duty) * DutyScale[Timer]) >> DUTY_SCALE_SHIFT)
 
+//commanded duty cycles are kept as Q16 fractions of the period, FRACTION_FULL is 100%
+#define FRACTION_FULL 0x10000
+#define DUTY_TO_FRACTION(Duty) ((((Duty) << 16) + MAX_PWM / 2) / MAX_PWM)
+#define FRACTION_TO_DUTY(Fraction) (((Fraction) * MAX_PWM + 0x8000) >> 16)
+
+#define CHANNEL_TIMER(Channel) ((GroupChannels[PWM_TIMER3] & (Channel)) ? PWM_TIMER3 : PWM_TIMER2)
+
+#define TIMER3_PRESCALE 8   //shared with the track wire input capture, see TrackWire.c
+#define PERIOD_INTERRUPTS (_IEC0_T2IE_MASK | _IEC0_T3IE_MASK)
+
+
+
+/*******************************************************************************
+ * PRIVATE FUNCTION PROTOTYPES                                                 *
+ ******************************************************************************/
+
+static unsigned int PWM_FractionCounts(unsigned int Fraction, unsigned char Timer);
+static unsigned int PWM_ChannelConfig(unsigned char Channel);
+static void PWM_Rescale(unsigned char Timer);
+static void PWM_StageChannels(unsigned char Channels);
+static void PWM_EnablePeriodInterrupts(void);
+static void PWM_CommitGroup(unsigned char Timer);
 
 /*******************************************************************************
  * PRIVATE VARIABLES                                                            *
@@ -43,8 +68,16 @@ static unsigned char PWMActive = FALSE;
 static volatile unsigned int * const Duty_Registers[] = {&OC1RS, &OC2RS, &OC3RS, &OC4RS, &OC5RS};
 static volatile unsigned int * const Reset_Registers[] = {&OC1R, &OC2R, &OC3R, &OC4R, &OC5R};
 static volatile unsigned int * const Config_Registers[] = {&OC1CON, &OC2CON, &OC3CON, &OC4CON, &OC5CON};
+static const unsigned int PeriodEnable[NUM_PWM_TIMERS] = {_IEC0_T2IE_MASK, _IEC0_T3IE_MASK};
+static const unsigned int PeriodFlag[NUM_PWM_TIMERS] = {_IFS0_T2IF_MASK, _IFS0_T3IF_MASK};
 static unsigned int PWMActivePins;
-static unsigned int PWMFrequency;
+static unsigned int PWMFrequency[NUM_PWM_TIMERS];
+static unsigned int Period[NUM_PWM_TIMERS];             //timer counts per PWM period, PRx + 1
+static unsigned int DutyScale[NUM_PWM_TIMERS];
+static unsigned char GroupChannels[NUM_PWM_TIMERS];     //PWM_PORTxxx run from each timer
+static unsigned int CommandedFraction[NUM_PWM_CHANNELS];
+static unsigned int StagedDuty[NUM_PWM_CHANNELS];       //OCxRS values waiting for the period interrupt
+static volatile unsigned char StagedChannels = 0;
 
 /*******************************************************************************
  * PUBLIC FUNCTIONS                                                           *
@@ -64,8 +97,16 @@ char PWM_Init(void)
         return ERROR;
     }
     PWMActive = TRUE;
-    PWM_SetFrequency(PWM_DEFAULT_FREQUENCY);
     PWMActivePins = 0;
+    GroupChannels[PWM_TIMER2] = ALLPWMPINS;
+    GroupChannels[PWM_TIMER3] = 0;
+    PWMFrequency[PWM_TIMER3] = 0;
+    PWM_SetFrequency(PWM_DEFAULT_FREQUENCY);
+    StagedChannels = 0;
+    //the period interrupts are only enabled while PWM_SetDutyCycles has values staged
+    IEC0CLR = PERIOD_INTERRUPTS;
+    IPC2bits.T2IP = 3;
+    IPC3bits.T3IP = 3;
     return SUCCESS;
 }
 
@@ -74,7 +115,7 @@ char PWM_Init(void)
  * @param NewFrequency - new frequency to set. best to use #defined from header
  * @return SUCCESS OR ERROR
  * @brief  Changes the frequency of the PWM system.
- * @note  Behavior of PWM channels during Frequency change is undocumented
+ * @note  Active channels are rescaled to keep their duty cycles at the new period
  * @author Max Dunne, 2013.08.19 */
 char PWM_SetFrequency(unsigned int NewFrequency)
 {
@@ -99,9 +140,11 @@ char PWM_SetFrequency(unsigned int NewFrequency)
         PR2 = F_PB / NewFrequency;
         dbprintf("Period greater than 1KHz, setting prescaler to 1\r\n");
     }
+    Period[PWM_TIMER2] = PR2 + 1;
+    PWM_Rescale(PWM_TIMER2);
     TMR2 = 0;
     T2CONbits.ON = 1;
-    PWMFrequency = NewFrequency;
+    PWMFrequency[PWM_TIMER2] = NewFrequency;
     return SUCCESS;
 }
 
@@ -116,7 +159,96 @@ unsigned int PWM_GetFrequency(void)
         dbprintf("%s called before enable\r\n", __FUNCTION__);
         return ERROR;
     }
-    return (PWMFrequency);
+    return (PWMFrequency[PWM_TIMER2]);
+}
+
+/**
+ * @Function PWM_SetGroupFrequency(unsigned char Timer, unsigned int NewFrequency)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3
+ * @param NewFrequency - new frequency of the group in Hertz
+ * @return SUCCESS OR ERROR
+ * @brief  Timer2 is the same as PWM_SetFrequency. Timer3 keeps its 1:8 prescaler,
+ *         which the track wire capture counts with, and only the period changes, so
+ *         its range is MIN_PWM_FREQ to PWM_TIMER3_MAX_FREQ. */
+char PWM_SetGroupFrequency(unsigned char Timer, unsigned int NewFrequency)
+{
+    if (Timer == PWM_TIMER2) {
+        return PWM_SetFrequency(NewFrequency);
+    }
+    if (!PWMActive || (Timer != PWM_TIMER3)) {
+        dbprintf("%s called before enable or with a bad timer\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    if ((NewFrequency < MIN_PWM_FREQ) || (PWM_TIMER3_MAX_FREQ < NewFrequency)) {
+        dbprintf("%s called with frequency outside bounds: %d", __FUNCTION__, NewFrequency);
+        return ERROR;
+    }
+    //the track wire may already have Timer3 free running, it is not restarted
+    if (!T3CONbits.ON) {
+        T3CON = 0;
+        T3CONbits.TCKPS = 0b011; //1:8
+        TMR3 = 0;
+        T3CONbits.ON = 1;
+    }
+    PR3 = F_PB / TIMER3_PRESCALE / NewFrequency;
+    if (TMR3 > PR3) {
+        TMR3 = 0;
+    }
+    Period[PWM_TIMER3] = PR3 + 1;
+    PWM_Rescale(PWM_TIMER3);
+    PWMFrequency[PWM_TIMER3] = NewFrequency;
+    return SUCCESS;
+}
+
+/**
+ * @Function PWM_GetGroupFrequency(unsigned char Timer)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3
+ * @return frequency of the group in Hertz, 0 for a bad timer or Timer3 not yet set */
+unsigned int PWM_GetGroupFrequency(unsigned char Timer)
+{
+    if (!PWMActive || (Timer >= NUM_PWM_TIMERS)) {
+        return 0;
+    }
+    return PWMFrequency[Timer];
+}
+
+/**
+ * @Function PWM_SetGroup(unsigned char Channels, unsigned char Timer)
+ * @param Channels - #defined PWM_PORTxxx OR'd together
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3, the timer the channels count their period on
+ * @return SUCCESS OR ERROR
+ * @brief  Active channels are stopped for a moment and restarted on the new timer with
+ *         the same duty cycle. Timer3 needs PWM_SetGroupFrequency first. */
+char PWM_SetGroup(unsigned char Channels, unsigned char Timer)
+{
+    unsigned char Channel;
+    unsigned int Counts;
+
+    if (!PWMActive) {
+        dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    if ((Channels == 0) || (Channels & ~ALLPWMPINS) || (Timer >= NUM_PWM_TIMERS) || (PWMFrequency[Timer] == 0)) {
+        dbprintf("%s returning ERROR with bad pins or timer: %X %d\r\n", __FUNCTION__, Channels, Timer);
+        return ERROR;
+    }
+    IEC0CLR = PERIOD_INTERRUPTS;
+    StagedChannels &= ~Channels;
+    GroupChannels[PWM_TIMER2] &= ~Channels;
+    GroupChannels[PWM_TIMER3] &= ~Channels;
+    GroupChannels[Timer] |= Channels;
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (Channels & PWMActivePins & (1 << Channel)) {
+            //the timer select cannot change while the module is on
+            *Config_Registers[Channel] &= (~_OC1CON_ON_MASK);
+            Counts = PWM_FractionCounts(CommandedFraction[Channel], Timer);
+            *Duty_Registers[Channel] = Counts;
+            *Reset_Registers[Channel] = Counts;
+            *Config_Registers[Channel] = PWM_ChannelConfig(Channel);
+        }
+    }
+    PWM_EnablePeriodInterrupts();
+    return SUCCESS;
 }
 
 /**
@@ -147,8 +279,8 @@ char PWM_AddPins(unsigned short int AddPins)
         if (AddPins & (1 << PinCount)) {
             *Duty_Registers[PinCount] = 0;
             *Reset_Registers[PinCount] = 0;
-            // we can use OC1 for all masks as the registers don't change
-            *Config_Registers[PinCount] = (_OC1CON_ON_MASK | 0b110 << _OC1CON_OCM_POSITION);
+            CommandedFraction[PinCount] = 0;
+            *Config_Registers[PinCount] = PWM_ChannelConfig(PinCount);
             dbprintf("PWM pin #%d has been added to the system\r\n", PinCount);
         }
     }
@@ -178,14 +310,18 @@ char PWM_RemovePins(unsigned int PWMPins)
         return ERROR;
     }
     int PinCount = 0;
+    IEC0CLR = PERIOD_INTERRUPTS;
+    StagedChannels &= ~PWMPins;
     for (PinCount = 0; PinCount < ALLPWMPINS; PinCount++) {
         if (PWMPins & (1 << PinCount)) {
             *Duty_Registers[PinCount] = 0;
             *Reset_Registers[PinCount] = 0;
             *Config_Registers[PinCount] &= (~_OC1CON_ON_MASK);
+            CommandedFraction[PinCount] = 0;
         }
     }
     PWMActivePins &= (~PWMPins);
+    PWM_EnablePeriodInterrupts();
     return SUCCESS;
 }
 
@@ -206,7 +342,8 @@ unsigned int PWM_ListPins(void)
  * @param Channels, use #defined PWM_PORTxxx
  * @param Duty, duty cycle for the channel (0-1000)
  * @return SUCCESS or ERROR
- * @remark Sets the Duty Cycle for a Single Channel and returns error if that channel is not enabled
+ * @remark Sets the Duty Cycle for a Single Channel and returns error if that channel is not enabled.
+ *         The new value is written straight away and replaces one staged for the channel.
  * @author Max Dunne
  * @date 2011.11.12  */
 char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty)
@@ -230,15 +367,117 @@ char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty)
 
     unsigned int ScaledDuty = 0;
     unsigned int TranslatedChannel = 0;
-    ScaledDuty = ((PR2 + 1) * Duty) / MAX_PWM;
+    ScaledDuty = SCALE_DUTY(Duty, CHANNEL_TIMER(Channel));
     while (Channel > 1) {
         Channel >>= 1;
         TranslatedChannel++;
     }
     dbprintf("Translated Channel is %d and Scaled Duty is %d\r\n", TranslatedChannel, ScaledDuty);
+    //otherwise the period interrupt could put a staged value back over this one
+    IEC0CLR = PERIOD_INTERRUPTS;
+    StagedChannels &= ~(1 << TranslatedChannel);
+    CommandedFraction[TranslatedChannel] = DUTY_TO_FRACTION(Duty);
     *Duty_Registers[TranslatedChannel] = ScaledDuty;
+    PWM_EnablePeriodInterrupts();
+    return SUCCESS;
+
+}
+
+/**
+ * Function  PWM_SetDutyCycles
+ * @param Channels, #defined PWM_PORTxxx OR'd together
+ * @param Duty, duty cycle (0-1000) of each channel, indexed by PWM_CHANNEL_x
+ * @return SUCCESS or ERROR
+ * @remark Checks and scales every duty cycle, then stages them for the period
+ *         interrupt of each channel's timer. That writes all the staged OCxRS registers
+ *         at the start of a period, and the hardware moves them into OCxR together at
+ *         its end, so the channels of a group always change in the same PWM cycle.
+ *         Nothing is staged if any channel is out of range or not enabled. */
+char PWM_SetDutyCycles(unsigned char Channels, const unsigned int *Duty)
+{
+    unsigned char Channel;
+
+    if (!PWMActive) {
+        dbprintf("%s returning ERROR before enable\r\n", __FUNCTION__);
+        return ERROR;
+    }
+    if ((Channels == 0) || (Channels & ~ALLPWMPINS) || ((Channels & PWMActivePins) != Channels)) {
+        dbprintf("%s returning error with bad or unactivated pins: %X %X\r\n", __FUNCTION__, Channels, PWMActivePins);
+        return ERROR;
+    }
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (Channels & (1 << Channel)) {
+            if (Duty[Channel] > MAX_PWM) {
+                dbprintf("%s returning error with duty cycle out of bounds: %d\r\n", __FUNCTION__, Duty[Channel]);
+                return ERROR;
+            }
+        }
+    }
+    IEC0CLR = PERIOD_INTERRUPTS;
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (Channels & (1 << Channel)) {
+            StagedDuty[Channel] = SCALE_DUTY(Duty[Channel], CHANNEL_TIMER(1 << Channel));
+            CommandedFraction[Channel] = DUTY_TO_FRACTION(Duty[Channel]);
+        }
+    }
+    PWM_StageChannels(Channels);
+    return SUCCESS;
+}
+
+/**
+ * Function  PWM_SetDutyFraction
+ * @param Channel, use #defined PWM_PORTxxx
+ * @param Fraction, on time as a fraction of the period in 1/65536ths, PWM_FRACTION_FULL
+ *        is always on
+ * @return SUCCESS or ERROR
+ * @remark Same as PWM_SetDutyCycle at the full resolution of the channel's timer */
+char PWM_SetDutyFraction(unsigned char Channel, uint16_t Fraction)
+{
+    unsigned int TranslatedChannel = 0;
+    unsigned int Full;
+
+    if (!PWMActive || (Channel == 0) || (Channel > ALLPWMPINS) || !(Channel & PWMActivePins)) {
+        dbprintf("%s returning error with bad or unactivated pin: %X %X\r\n", __FUNCTION__, Channel, PWMActivePins);
+        return ERROR;
+    }
+    Full = (Fraction == PWM_FRACTION_FULL) ? FRACTION_FULL : Fraction;
+    while ((1 << TranslatedChannel) != Channel) {
+        TranslatedChannel++;
+    }
+    IEC0CLR = PERIOD_INTERRUPTS;
+    StagedChannels &= ~Channel;
+    CommandedFraction[TranslatedChannel] = Full;
+    *Duty_Registers[TranslatedChannel] = PWM_FractionCounts(Full, CHANNEL_TIMER(Channel));
+    PWM_EnablePeriodInterrupts();
     return SUCCESS;
+}
+
+/**
+ * Function  PWM_SetDutyFractions
+ * @param Channels, #defined PWM_PORTxxx OR'd together
+ * @param Fraction, on time of each channel in 1/65536ths of the period, indexed by
+ *        PWM_CHANNEL_x, PWM_FRACTION_FULL is always on
+ * @return SUCCESS or ERROR
+ * @remark Same as PWM_SetDutyCycles at the full resolution of each channel's timer */
+char PWM_SetDutyFractions(unsigned char Channels, const uint16_t *Fraction)
+{
+    unsigned char Channel;
+    unsigned int Full;
 
+    if (!PWMActive || (Channels == 0) || (Channels & ~ALLPWMPINS) || ((Channels & PWMActivePins) != Channels)) {
+        dbprintf("%s returning error with bad or unactivated pins: %X %X\r\n", __FUNCTION__, Channels, PWMActivePins);
+        return ERROR;
+    }
+    IEC0CLR = PERIOD_INTERRUPTS;
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (Channels & (1 << Channel)) {
+            Full = (Fraction[Channel] == PWM_FRACTION_FULL) ? FRACTION_FULL : Fraction[Channel];
+            StagedDuty[Channel] = PWM_FractionCounts(Full, CHANNEL_TIMER(1 << Channel));
+            CommandedFraction[Channel] = Full;
+        }
+    }
+    PWM_StageChannels(Channels);
+    return SUCCESS;
 }
 
 /**
@@ -246,7 +485,8 @@ char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty)
  * @param Channels, use #defined PWM_PORTxxx
  *
  * @return Duty cycle
- * @remark Gets the Duty Cycle for a Single Channel and returns error if that channel is not enabled
+ * @remark Gets the Duty Cycle for a Single Channel and returns error if that channel is not enabled.
+ *         This is the last duty cycle set, even while it is still staged.
  * @author Max Dunne
  * @date 2011.11.12  */
 unsigned int PWM_GetDutyCycle(char Channel)
@@ -264,7 +504,6 @@ unsigned int PWM_GetDutyCycle(char Channel)
         return ERROR;
     }
 
-    unsigned int ScaledDuty = 0;
     unsigned int Duty = 0;
     unsigned int TranslatedChannel = 0;
 
@@ -272,12 +511,7 @@ unsigned int PWM_GetDutyCycle(char Channel)
         Channel >>= 1;
         TranslatedChannel++;
     }
-    ScaledDuty = *Duty_Registers[TranslatedChannel];
-    Duty = (ScaledDuty * MAX_PWM) / (PR2 + 1) + 1;
-    if (Duty > MAX_PWM) {
-        //one off error due to integer division
-        Duty = MAX_PWM;
-    }
+    Duty = FRACTION_TO_DUTY(CommandedFraction[TranslatedChannel]);
     dbprintf("Translated Channel is %d and unScaled Duty is %d\r\n", TranslatedChannel, Duty);
 
     return Duty;
@@ -288,7 +522,8 @@ unsigned int PWM_GetDutyCycle(char Channel)
  * Function: PWM_End
  * @param None
  * @return SUCCESS or ERROR
- * @remark Disables the PWM sub-system and releases all pins.
+ * @remark Disables the PWM sub-system and releases all pins. Timer3 is left running
+ *         for the track wire.
  * @author Max Dunne
  * @date 2011.11.12  */
 char PWM_End(void)
@@ -297,17 +532,149 @@ char PWM_End(void)
     if (!PWMActive) {
         return ERROR;
     }
+    IEC0CLR = PERIOD_INTERRUPTS | _IEC0_OC1IE_MASK | _IEC0_OC2IE_MASK | _IEC0_OC3IE_MASK | _IEC0_OC4IE_MASK | _IEC0_OC5IE_MASK;
+    StagedChannels = 0;
     for (Curpin = 0; Curpin < NUM_PWM_CHANNELS; Curpin++) {
         *Duty_Registers[Curpin] = 0;
         *Reset_Registers[Curpin] = 0;
+        CommandedFraction[Curpin] = 0;
     }
-    IEC0CLR = _IEC0_T2IE_MASK | _IEC0_OC1IE_MASK | _IEC0_OC2IE_MASK | _IEC0_OC3IE_MASK | _IEC0_OC4IE_MASK | _IEC0_OC5IE_MASK;
 
     PWMActive = FALSE;
-    PWMFrequency = 0;
+    PWMFrequency[PWM_TIMER2] = 0;
+    PWMFrequency[PWM_TIMER3] = 0;
     return SUCCESS;
 }
 
+/**
+ * @function Timer2IntHandler
+ * @param None
+ * @return None
+ * @brief Runs at the start of a Timer2 period while duty cycles are staged for its
+ *        group. Commits them all to OCxRS and turns itself off until more are staged.
+ * @note This function is not to be called by the user */
+void __ISR(_TIMER_2_VECTOR) Timer2IntHandler(void)
+{
+    IFS0CLR = _IFS0_T2IF_MASK;
+    PWM_CommitGroup(PWM_TIMER2);
+}
+
+/**
+ * @function Timer3IntHandler
+ * @param None
+ * @return None
+ * @brief Same as Timer2IntHandler for the Timer3 group
+ * @note This function is not to be called by the user */
+void __ISR(_TIMER_3_VECTOR) Timer3IntHandler(void)
+{
+    IFS0CLR = _IFS0_T3IF_MASK;
+    PWM_CommitGroup(PWM_TIMER3);
+}
+
+/*******************************************************************************
+ * PRIVATE FUNCTIONS                                                           *
+ ******************************************************************************/
+
+/**
+ * @Function PWM_FractionCounts(unsigned int Fraction, unsigned char Timer)
+ * @param Fraction - Q16 fraction of the period, FRACTION_FULL for always on
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3
+ * @return OCxRS value for the fraction at the timer's period */
+static unsigned int PWM_FractionCounts(unsigned int Fraction, unsigned char Timer)
+{
+    if (Fraction >= FRACTION_FULL) {
+        return Period[Timer];
+    }
+    return (Period[Timer] * Fraction) >> 16;
+}
+
+/**
+ * @Function PWM_ChannelConfig(unsigned char Channel)
+ * @param Channel - PWM_CHANNEL_x
+ * @return OCxCON value to run the channel as PWM from the timer of its group */
+static unsigned int PWM_ChannelConfig(unsigned char Channel)
+{
+    unsigned int Config = (_OC1CON_ON_MASK | 0b110 << _OC1CON_OCM_POSITION);
+
+    // we can use OC1 for all masks as the registers don't change
+    if (GroupChannels[PWM_TIMER3] & (1 << Channel)) {
+        Config |= _OC1CON_OCTSEL_MASK;
+    }
+    return Config;
+}
+
+/**
+ * @Function PWM_Rescale(unsigned char Timer)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3, after its period has changed
+ * @return None
+ * @brief Works out the duty scale for the new period and moves the active channels of
+ *        the group to it, keeping their duty cycles */
+static void PWM_Rescale(unsigned char Timer)
+{
+    unsigned char Channel;
+
+    //rounded up so full duty still reaches the whole period
+    DutyScale[Timer] = ((Period[Timer] << DUTY_SCALE_SHIFT) + MAX_PWM - 1) / MAX_PWM;
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (PWMActivePins & GroupChannels[Timer] & (1 << Channel)) {
+            *Duty_Registers[Channel] = PWM_FractionCounts(CommandedFraction[Channel], Timer);
+            StagedDuty[Channel] = *Duty_Registers[Channel];
+        }
+    }
+}
+
+/**
+ * @Function PWM_StageChannels(unsigned char Channels)
+ * @param Channels - PWM_PORTxxx whose StagedDuty has just been written
+ * @return None
+ * @brief Called with the period interrupts off, turns on the ones the channels need */
+static void PWM_StageChannels(unsigned char Channels)
+{
+    unsigned char Timer;
+
+    for (Timer = 0; Timer < NUM_PWM_TIMERS; Timer++) {
+        //a flag left from an earlier period would commit in the middle of this one
+        if ((Channels & GroupChannels[Timer]) && !(StagedChannels & GroupChannels[Timer])) {
+            IFS0CLR = PeriodFlag[Timer];
+        }
+    }
+    StagedChannels |= Channels;
+    PWM_EnablePeriodInterrupts();
+}
+
+/**
+ * @Function PWM_EnablePeriodInterrupts(void)
+ * @return None
+ * @brief Turns on the period interrupt of each group with channels staged */
+static void PWM_EnablePeriodInterrupts(void)
+{
+    unsigned char Timer;
+
+    for (Timer = 0; Timer < NUM_PWM_TIMERS; Timer++) {
+        if (StagedChannels & GroupChannels[Timer]) {
+            IEC0SET = PeriodEnable[Timer];
+        }
+    }
+}
+
+/**
+ * @Function PWM_CommitGroup(unsigned char Timer)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3, whose period has just started
+ * @return None
+ * @brief Writes the staged duty cycles of the group and turns its interrupt off */
+static void PWM_CommitGroup(unsigned char Timer)
+{
+    unsigned char Channels = StagedChannels & GroupChannels[Timer];
+    unsigned char Channel;
+
+    for (Channel = 0; Channel < NUM_PWM_CHANNELS; Channel++) {
+        if (Channels & (1 << Channel)) {
+            *Duty_Registers[Channel] = StagedDuty[Channel];
+        }
+    }
+    StagedChannels &= ~Channels;
+    IEC0CLR = PeriodEnable[Timer];
+}
 
 /*******************************************************************************
  * TEST HARNESS                                                                *
@@ -339,6 +706,8 @@ int main(void)
     unsigned int wait = 0;
     unsigned short int duty;
     unsigned short int i, j, k;
+    unsigned int Duties[NUM_PWM_CHANNELS];
+    unsigned int Expected;
     char testPassed = FALSE;
     //    int8_t wantedResult = SUCCESS;
     DELAY(A_BIT);
@@ -762,10 +1131,63 @@ int main(void)
     if (testPassed) printf("PASSED");
     printf("\nPWM_GetPulseTime() Tests complete");
 
+    /***************************************************************************
+     *            TEST PWM_SETDUTYCYCLES()                                      *
+     ***************************************************************************/
+    printf("\n\nTesting: PWM_SetDutyCycles() on all pins after a period: ");
+    testPassed = TRUE;
+    for (i = 0; i < NUM_PWM_CHANNELS; i++) {
+        Duties[i] = INC * (i + 1);
+    }
+    PWM_SetDutyCycles(ALLPWMPINS, Duties);
+    DELAY(A_LOT);
+    for (i = 0; i < NUM_PWM_CHANNELS; i++) {
+        Expected = ((PR2 + 1) * Duties[i]) / MAX_PWM;
+        if ((*Duty_Registers[i] < Expected) || (*Duty_Registers[i] > Expected + 1)) {
+            printf("\nChannel %d OCxRS is %d instead of %d", i, *Duty_Registers[i], Expected);
+            testPassed = FALSE;
+        }
+    }
+    if (testPassed) printf("PASSED");
+
+    /***************************************************************************
+     *            TEST PWM_SETGROUP()                                           *
+     ***************************************************************************/
+    printf("\n\nTesting: PWM_SetGroup() before the Timer3 frequency: ");
+    if (PWM_SetGroup(PWM_PORTX11, PWM_TIMER3) == ERROR) {
+        printf("PASSED");
+    } else {
+        printf("FAILED TEST");
+    }
+    printf("\nTesting: PWM_SetDutyFraction() on a Timer3 group channel: ");
+    testPassed = TRUE;
+    PWM_SetGroupFrequency(PWM_TIMER3, PWM_500HZ);
+    PWM_SetGroup(PWM_PORTX11 | PWM_PORTY04, PWM_TIMER3);
+    if (!(OC5CON & _OC1CON_OCTSEL_MASK) || (OC1CON & _OC1CON_OCTSEL_MASK)) {
+        printf("\nOCxCON timer select not set for the group");
+        testPassed = FALSE;
+    }
+    if (PWM_GetDutyCycle(PWM_PORTX11) != Duties[PWM_CHANNEL_X11]) {
+        printf("\nPWM_GetDutyCycle() changed to %d by the group change", PWM_GetDutyCycle(PWM_PORTX11));
+        testPassed = FALSE;
+    }
+    PWM_SetDutyFraction(PWM_PORTX11, 0x4000);
+    if (*Duty_Registers[PWM_CHANNEL_X11] != (PR3 + 1) / 4) {
+        printf("\nQuarter OCxRS is %d instead of %d", *Duty_Registers[PWM_CHANNEL_X11], (PR3 + 1) / 4);
+        testPassed = FALSE;
+    }
+    PWM_SetDutyFraction(PWM_PORTX11, PWM_FRACTION_FULL);
+    if ((*Duty_Registers[PWM_CHANNEL_X11] != PR3 + 1) || (PWM_GetDutyCycle(PWM_PORTX11) != MAX_PWM)) {
+        printf("\nFull OCxRS is %d instead of %d", *Duty_Registers[PWM_CHANNEL_X11], PR3 + 1);
+        testPassed = FALSE;
+    }
+    PWM_SetGroup(PWM_PORTX11 | PWM_PORTY04, PWM_TIMER2);
+    if (testPassed) printf("PASSED");
+
 
 
     /***************************************************************************
-     *            TEST PWM_END()                                                *
+     *            TEST PWM_END()                                              *
      ***************************************************************************/
     printf("\nTesting: PWM_End() while enabled: ");
     if (PWM_End() == SUCCESS) {
@@ -6,7 +6,11 @@
  * which the PWM works are #defined below (PortZ-6, PortY-4,10,12, and PortX-11),
  * and are set by the hardware (cannot be modified).
  *
- * NOTE: Module uses TIMER2 for its interrupts.
+ * Each channel counts its period on Timer2 or Timer3, so two groups of channels can
+ * run at different frequencies. All channels start on Timer2.
+ *
+ * NOTE: Module uses TIMER2 and TIMER3 for its interrupts. Timer3 is shared with the
+ * track wire input capture and always runs at 1:8, see PWM_SetGroupFrequency.
  *
  * PWM_TEST (in the .c file) conditionally compiles the test harness for the code. 
  * 
@@ -17,6 +21,8 @@
 #ifndef pwm_H
 #define pwm_H
 
+#include <stdint.h>
+
 /*******************************************************************************
  * PUBLIC #DEFINES                                                             *
  ******************************************************************************/
@@ -38,9 +44,26 @@
 #define PWM_PORTY04 (1<<3)
 #define PWM_PORTX11 (1<<4)
 
+//index of each channel in the PWM_SetDutyCycles array, PWM_PORTxxx is (1 << PWM_CHANNEL_xxx)
+#define PWM_CHANNEL_Z06 0
+#define PWM_CHANNEL_Y12 1
+#define PWM_CHANNEL_Y10 2
+#define PWM_CHANNEL_Y04 3
+#define PWM_CHANNEL_X11 4
+#define NUM_PWM_CHANNELS 5
+
 #define MIN_PWM 0
 #define MAX_PWM 1000
 
+//timers a group of channels can run from
+#define PWM_TIMER2 0
+#define PWM_TIMER3 1
+#define NUM_PWM_TIMERS 2
+#define PWM_TIMER3_MAX_FREQ PWM_2KHZ    //keeps PR3 long enough for the track wire capture
+
+//PWM_SetDutyFraction takes the on time in 1/65536ths of the period, this one is always on
+#define PWM_FRACTION_FULL 0xFFFF
+
 
 
 /*******************************************************************************
@@ -61,7 +84,7 @@ char PWM_Init(void);
  * @param NewFrequency - new frequency to set. best to use #defined from header
  * @return SUCCESS OR ERROR
  * @brief  Changes the frequency of the PWM system.
- * @note  Behavior of PWM channels during Frequency change is undocumented
+ * @note  Active channels are rescaled to keep their duty cycles at the new period
  * @author Max Dunne, 2013.08.19 */
 char PWM_SetFrequency(unsigned int NewFrequency);
 
@@ -72,6 +95,31 @@ char PWM_SetFrequency(unsigned int NewFrequency);
  * @author Max Dunne, 2013.08.19 */
 unsigned int PWM_GetFrequency(void);
 
+/**
+ * @Function PWM_SetGroupFrequency(unsigned char Timer, unsigned int NewFrequency)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3
+ * @param NewFrequency - new frequency of the group in Hertz
+ * @return SUCCESS OR ERROR
+ * @brief  Timer2 is the same as PWM_SetFrequency. Timer3 keeps its 1:8 prescaler,
+ *         which the track wire capture counts with, and only the period changes, so
+ *         its range is MIN_PWM_FREQ to PWM_TIMER3_MAX_FREQ. */
+char PWM_SetGroupFrequency(unsigned char Timer, unsigned int NewFrequency);
+
+/**
+ * @Function PWM_GetGroupFrequency(unsigned char Timer)
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3
+ * @return frequency of the group in Hertz, 0 for a bad timer or Timer3 not yet set */
+unsigned int PWM_GetGroupFrequency(unsigned char Timer);
+
+/**
+ * @Function PWM_SetGroup(unsigned char Channels, unsigned char Timer)
+ * @param Channels - #defined PWM_PORTxxx OR'd together
+ * @param Timer - PWM_TIMER2 or PWM_TIMER3, the timer the channels count their period on
+ * @return SUCCESS OR ERROR
+ * @brief  Active channels are stopped for a moment and restarted on the new timer with
+ *         the same duty cycle. Timer3 needs PWM_SetGroupFrequency first. */
+char PWM_SetGroup(unsigned char Channels, unsigned char Timer);
+
 /**
  * @Function PWM_AddPins(unsigned short int AddPins)
  * @param AddPins - use #defined PWM_PORTxxx OR'd together for each A/D Pin you wish to add
@@ -103,17 +151,48 @@ unsigned int PWM_ListPins(void);
  * @param Channels, use #defined PWM_PORTxxx
  * @param Duty, duty cycle for the channel (0-1000)
  * @return SUCCESS or ERROR
- * @remark Sets the Duty Cycle for a Single Channel and returns error if that channel is not enabled
+ * @remark Sets the Duty Cycle for a Single Channel and returns error if that channel is not enabled.
+ *         The new value is written straight away and replaces one staged for the channel.
  * @author Max Dunne
  * @date 2011.11.12  */
 char PWM_SetDutyCycle(unsigned char Channel, unsigned int Duty);
 
+/**
+ * Function  PWM_SetDutyCycles
+ * @param Channels, #defined PWM_PORTxxx OR'd together
+ * @param Duty, array of NUM_PWM_CHANNELS duty cycles (0-1000) indexed by PWM_CHANNEL_xxx,
+ *        only the entries for Channels are used
+ * @return SUCCESS or ERROR
+ * @remark Updates several channels in the same PWM cycle of their group. The values
+ *         are staged and committed by the period interrupt of each channel's timer, so
+ *         they take effect at the end of the next full period rather than straight away */
+char PWM_SetDutyCycles(unsigned char Channels, const unsigned int *Duty);
+
+/**
+ * Function  PWM_SetDutyFraction
+ * @param Channel, use #defined PWM_PORTxxx
+ * @param Fraction, on time as a fraction of the period in 1/65536ths, PWM_FRACTION_FULL
+ *        is always on
+ * @return SUCCESS or ERROR
+ * @remark Same as PWM_SetDutyCycle at the full resolution of the channel's timer */
+char PWM_SetDutyFraction(unsigned char Channel, uint16_t Fraction);
+
+/**
+ * Function  PWM_SetDutyFractions
+ * @param Channels, #defined PWM_PORTxxx OR'd together
+ * @param Fraction, on time of each channel in 1/65536ths of the period, indexed by
+ *        PWM_CHANNEL_x, PWM_FRACTION_FULL is always on
+ * @return SUCCESS or ERROR
+ * @remark Same as PWM_SetDutyCycles at the full resolution of each channel's timer */
+char PWM_SetDutyFractions(unsigned char Channels, const uint16_t *Fraction);
+
 /**
  * Function  PWM_GetDutyCycle
  * @param Channels, use #defined PWM_PORTxxx
  * 
  * @return Duty cycle
- * @remark Gets the Duty Cycle for a Single Channel and returns error if that channel is not enabled
+ * @remark Gets the Duty Cycle for a Single Channel and returns error if that channel is not enabled.
+ *         This is the last duty cycle set, even while it is still staged.
  * @author Max Dunne
  * @date 2011.11.12  */
 unsigned int PWM_GetDutyCycle(char Channel);
@@ -122,7 +201,8 @@ unsigned int PWM_GetDutyCycle(char Channel);
  * Function: PWM_End
  * @param None
  * @return SUCCESS or ERROR
- * @remark Disables the PWM sub-system and releases all pins.
+ * @remark Disables the PWM sub-system and releases all pins. Timer3 is left running
+ *         for the track wire.
  * @author Max Dunne
  * @date 2011.11.12  */
 char PWM_End(void);